@@ -1,23 +1,32 @@
+#include <string>
+#include <vector>
+#include <iostream>
+
 #include "itensor/all.h"
 #include "clock/all.h"
 #include "utils/all.h"
 
+// Count the allocations, reported with the timings
+#ifdef CLOCK_COUNT_ALLOCATIONS
+#include "utils/allocation_hooks.h"
+#endif
+
 namespace it = itensor;
 namespace ut = utils;
 namespace cl = clocks;
 namespace sim = clocks::simulations;
 
-constexpr unsigned N = 3;          // clock order
-// constexpr unsigned n_points = 151; // number of points to compute
 constexpr unsigned n_excited = 4;  // number of excited states to compute
 
-int main(int argc, char ** argv)
+// Campaign for the clock order N, in the given mode (see main)
+template<unsigned N>
+int run_campaign(const std::string & mode, const std::string & queue_dir)
 {
     // Coupling range
-    constexpr unsigned n_points_full    = 151;
-    constexpr unsigned n_points_focused = 201;
-    auto couplings_full    = ut::linspace(1.,  1.5, n_points_full).to_array<n_points_full>();
-    auto couplings_focused = ut::linspace(.75, .95, n_points_focused).to_array<n_points_focused>();
+    unsigned n_points_full    = 151;
+    unsigned n_points_focused = 201;
+    auto couplings_full    = ut::linspace(1.,  1.5, n_points_full).to_vector();
+    auto couplings_focused = ut::linspace(.75, .95, n_points_focused).to_vector();
 
     // Chain lengths
     // auto length = 10;
@@ -32,35 +41,87 @@ int main(int argc, char ** argv)
     // Sector
     // unsigned max_sector = N/2 + 1;
     unsigned sector = 1;
+
+    // The response to the phase noise comes from the linear response
+    // columns; the +/- phase_noise scans of the finite differences are
+    // only a cross-check, with "FiniteDifference = yes" in the campaign
+    // group of sweeps_input
+    auto finite_difference = it::InputGroup(filename, "campaign").getYesNo("FiniteDifference", false);
     double phase_noise = 1e-4;
 
+    // All the scans of the campaign, scheduled together longest-first
+    auto campaign = sim::Campaign<N, n_excited>({
+            "Telemetry",       "campaign_telemetry",
+            "MemoryTelemetry", "campaign_memory"
+        });
     for (auto length : lengths) {
-        std::cout << "Clock N = " << N << ", size = " << length << "\n";
-        std::cout << "------------------------------------------------------------\n";
-
-        cout << " * Computing with no phase noise" << "\n";
-        auto results_no_eps = sim::ComputeObservables<N, n_points_full, n_excited>(
-                length, sweeps, couplings_full,
+        campaign.add(
+                length, sweeps, couplings_full, sector,
+                sim::csv_filename<N>(length, sector, "no_eps"),
                 {"OnlyBulk", true}
-            ).compute(sector);
-        results_no_eps.set_precision(12).to_csv(sim::csv_filename<N>(length, sector, "no_eps"));
+            );
+        campaign.add(
+                length, sweeps, couplings_focused, sector,
+                sim::csv_filename<N>(length, sector, "response"),
+                {"LinearResponse", true, "OnlyBulk", true}
+            );
+        if (finite_difference) {
+            campaign.add(
+                    length, sweeps, couplings_focused, sector,
+                    sim::csv_filename<N>(length, sector, "eps_pos_1e4"),
+                    {"PhaseNoise", phase_noise, "OnlyBulk", true}
+                );
+            campaign.add(
+                    length, sweeps, couplings_focused, sector,
+                    sim::csv_filename<N>(length, sector, "eps_neg_1e4"),
+                    {"PhaseNoise", -phase_noise, "OnlyBulk", true}
+                );
+        }
+    }
 
-        cout << " * Computing with phase noise = " << phase_noise << "\n";
-        auto results_pos_eps = sim::ComputeObservables<N, n_points_focused, n_excited>(
-                length, sweeps, couplings_focused,
-                {"PhaseNoise", phase_noise, "OnlyBulk", true}
-            ).compute(sector);
-        results_pos_eps.set_precision(12).to_csv(sim::csv_filename<N>(length, sector, "eps_pos_1e4"));
+    std::cout << "Clock N = " << N << ", sizes = " << lengths.to_vector().front()
+              << ".." << lengths.to_vector().back() << "\n";
+    std::cout << "------------------------------------------------------------\n";
 
-        cout << " * Computing with phase noise = " << -phase_noise << "\n";
-        auto results_neg_eps = sim::ComputeObservables<N, n_points_focused, n_excited>(
-                length, sweeps, couplings_focused,
-                {"PhaseNoise", -phase_noise, "OnlyBulk", true}
-            ).compute(sector);
-        results_neg_eps.set_precision(12).to_csv(sim::csv_filename<N>(length, sector, "eps_neg_1e4"));
+    if (mode == "run")
+        campaign.run();
+    else if (mode == "enqueue")
+        campaign.enqueue(queue_dir);
+    else if (mode == "work")
+        campaign.work(queue_dir);
+    else
+        campaign.merge(queue_dir);
+    return 0;
+}
+
+int main(int argc, char ** argv)
+{
+    // Without arguments the whole campaign runs in this process, otherwise
+    //      app enqueue <dir>   writes all the points to a work queue
+    //      app work <dir>      computes points of the queue (any number of workers)
+    //      app merge <dir>     writes the csv files once the queue is done
+    // The clock order is "-N <order>", or N in the campaign group of
+    // sweeps_input, any of the precompiled ones (see clock/dispatch.h)
+    std::vector<std::string> positional{};
+    int order = 0;
+    for (int n = 1; n < argc; n++) {
+        if (std::string(argv[n]) == "-N" && n + 1 < argc)
+            order = std::stoi(argv[++n]);
+        else
+            positional.emplace_back(argv[n]);
+    }
+    if (order == 0)
+        order = it::InputGroup("sweeps_input", "campaign").getInt("N", 3);
 
-        std::cout << "\n";
+    auto mode = positional.empty() ? std::string("run") : positional[0];
+    bool with_dir = mode == "enqueue" || mode == "work" || mode == "merge";
+    if ((mode != "run" && !with_dir) || (with_dir && positional.size() < 2)) {
+        std::cerr << "Usage: " << argv[0] << " [-N <order>] [enqueue|work|merge <queue dir>]\n";
+        return 1;
     }
+    auto queue_dir = with_dir ? positional[1] : std::string{};
 
-    return 0;
+    return cl::with_clock_order(order, [&](auto clock_order) {
+            return run_campaign<decltype(clock_order)::value>(mode, queue_dir);
+        });
 }
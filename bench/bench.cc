@@ -0,0 +1,102 @@
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "itensor/all.h"
+#include "../clock/all.h"
+#include "../utils/all.h"
+
+namespace it = itensor;
+namespace ut = utils;
+namespace cl = clocks;
+namespace sim = clocks::simulations;
+
+constexpr unsigned N = 3;
+
+// Benchmarks of the single subsystems on a small fixed problem.
+//      bench <results.json> [<baseline.json> [<tolerance>]]
+// writes the results and, with a baseline, flags the benchmarks whose
+// median is slower than the baseline by more than the tolerance (0.2).
+// A benchmark missing from a baseline is a failure too; an empty
+// baseline, as committed before one is recorded on the reference machine
+// with `make bench-baseline`, only gives a warning
+int main(int argc, char ** argv)
+{
+    std::string results  = argc > 1 ? argv[1] : "bench/results.json";
+    std::string baseline = argc > 2 ? argv[2] : "";
+    double tolerance     = argc > 3 ? std::stod(argv[3]) : 0.2;
+
+    // Fixed problem, with a deterministic random initial state
+    it::seedRNG(1);
+    unsigned length = 20;
+    auto sites = cl::Clock<N>(length, {"ConserveQNs", false});
+    auto sweeps = it::Sweeps(4);
+    sweeps.maxdim() = 10, 20, 50, 50;
+    sweeps.cutoff() = 1e-10;
+    sweeps.niter() = 2;
+    auto H = cl::hamiltonianC<N>(sites, -1.0, -1.0);
+    auto psi = it::randomMPS(sites);
+    dmrg(psi, H, sweeps, {"Silent", true});
+
+    std::vector<std::string> schema{};
+    for (auto n : ut::range(40))
+        schema.push_back("col_" + std::to_string(n));
+    auto table = ut::Table<std::vector<double>>(schema, 500, 0.123456789);
+
+    std::vector<ut::Benchmark> benchmarks{};
+    benchmarks.emplace_back("ClockSite::op", [&]{
+            for (auto i : it::range1(length))
+                for (auto op : {"X", "Xdag", "Z", "Zdag"})
+                    sites.op(op, i);
+        }, 100, 10);
+    benchmarks.emplace_back("hamiltonianC", [&]{
+            cl::hamiltonianC<N>(sites, -1.0, -1.0);
+        }, 20, 2);
+    benchmarks.emplace_back("compute_correlatorC", [&]{
+            cl::compute_correlatorC(sites, psi, "Z", "Zdag", {1, int(length/2)});
+        }, 20, 2);
+    benchmarks.emplace_back("compute_disorderC", [&]{
+            cl::compute_disorderC(sites, psi, "X", {int(length/4), int(3*length/4)});
+        }, 20, 2);
+    benchmarks.emplace_back("entropy_vN", [&]{
+            entropy_vN(psi, length/2);
+        }, 20, 2);
+    benchmarks.emplace_back("observables_at", [&]{
+            auto comp = sim::ComputeObservables<N, 1>(length, sweeps, {1.0});
+            comp.observables_at(1.0, 0);
+        }, 3, 1);
+    benchmarks.emplace_back("Table::to_csv", [&]{
+            table.to_csv("bench/table.csv");
+        }, 20, 2);
+
+    for (const auto & bench : benchmarks)
+        bench.print_statistics();
+    ut::write_json(results, benchmarks);
+    std::cout << "Results written onto '" << results << "'\n";
+
+    if (baseline.empty())
+        return 0;
+
+    // Regressions with respect to the baseline medians
+    auto reference = ut::read_medians(baseline);
+    if (reference.empty()) {
+        std::cerr << "Warning: baseline '" << baseline << "' has no benchmarks, nothing compared; "
+                  << "record one with `make bench-baseline`\n";
+        return 0;
+    }
+    unsigned regressions = 0;
+    for (const auto & bench : benchmarks) {
+        auto found = reference.find(bench.name());
+        if (found == reference.end()) {
+            std::cout << "   " << bench.name() << ": no baseline  MISSING\n";
+            regressions++;
+            continue;
+        }
+        auto ratio = bench.median() / found->second;
+        bool slower = ratio > 1.0 + tolerance;
+        regressions += slower;
+        std::cout << "   " << bench.name() << ": " << ratio << "x baseline"
+                  << (slower ? "  REGRESSION" : "") << "\n";
+    }
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,154 @@
+#include <tuple>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#include "itensor/all.h"
+#include "../clock/all.h"
+#include "../utils/all.h"
+
+namespace it = itensor;
+namespace ut = utils;
+namespace cl = clocks;
+namespace sim = clocks::simulations;
+
+// Scaling of the scans with the number of threads and the problem size.
+//      scaling <results.json> [<max threads>]
+// runs a small fixed scan for each (threads, L, N, maxdim) and writes one
+// JSON object per setting: throughput in points per hour, parallel
+// efficiency with respect to a single thread, and the time of each phase
+// of a single point (Hamiltonian, ground state, excited levels, measures).
+// The sweeps are reduced so that the whole matrix runs in a few minutes.
+
+struct Setting {
+    unsigned threads;
+    unsigned length;
+    unsigned N;
+    int maxdim;
+};
+
+// Reduced sweep schedule reaching maxdim
+inline it::Sweeps reduced_sweeps(int maxdim) {
+    auto sweeps = it::Sweeps(4);
+    sweeps.maxdim() = std::min(10, maxdim), std::min(20, maxdim), maxdim, maxdim;
+    sweeps.cutoff() = 1e-10;
+    sweeps.niter() = 2;
+    return sweeps;
+}
+
+// Seconds taken by func
+template<typename F>
+double seconds(F && func) {
+    auto begin = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// Time of each phase of a single point, on a single thread
+template<unsigned N>
+std::vector<std::pair<std::string, double>>
+phase_times(unsigned length, const it::Sweeps & sweeps) {
+    it::seedRNG(1);
+    auto comp = sim::ComputeObservables<N, 1>(length, sweeps, {1.0}, {"BlasThreads", 1});
+    it::MPO H;
+    it::MPS psi;
+    double energy;
+
+    std::vector<std::pair<std::string, double>> times{};
+    times.emplace_back("hamiltonian_s", seconds([&]{ H = comp.dual_hamiltonian(1.0, 0); }));
+    times.emplace_back("ground_state_s", seconds([&]{
+            std::tie(energy, psi) = comp.ground_state(H, 1.0, 0);
+        }));
+    times.emplace_back("excited_s", seconds([&]{ comp.excited_states(H, psi); }));
+    times.emplace_back("measurements_s", seconds([&]{
+            comp.disorder(psi);
+            comp.order(psi);
+            comp.transv_order(psi);
+            comp.half_chain_correlator(psi);
+            comp.correlator(psi, length/4, 3*length/4);
+        }));
+    return times;
+}
+
+// Time of a whole scan of n_points couplings
+template<unsigned N>
+double scan_time(const Setting & setting, unsigned n_points) {
+    it::seedRNG(1);
+    auto comp = sim::ComputeObservables<N, 1>(
+            setting.length,
+            reduced_sweeps(setting.maxdim),
+            ut::linspace<double>(0.5, 1.5, n_points).to_vector(),
+            {"TaskThreads", int(setting.threads), "BlasThreads", 1}
+        );
+    return seconds([&]{ comp.compute(0); });
+}
+
+int main(int argc, char ** argv)
+{
+    std::string results = argc > 1 ? argv[1] : "bench/scaling.json";
+    unsigned max_threads = argc > 2 ? std::stoul(argv[2]) : ut::allowed_cores().size();
+
+    std::vector<unsigned> threads_list{1};
+    for (unsigned t = 2; t <= max_threads; t *= 2)
+        threads_list.push_back(t);
+    auto lengths = std::vector<unsigned>{10, 20};
+    auto orders  = std::vector<unsigned>{3, 4};
+    auto maxdims = std::vector<int>{20, 50};
+
+    // same points for every number of threads, at least two per thread
+    unsigned n_points = 2 * threads_list.back();
+
+    std::ofstream file{results};
+    file << "[\n";
+    bool first = true;
+    for (auto N : orders)
+    for (auto length : lengths)
+    for (auto maxdim : maxdims) {
+        auto phases = cl::with_clock_order(N, [&](auto order) {
+                return phase_times<decltype(order)::value>(length, reduced_sweeps(maxdim));
+            });
+
+        double serial_rate = 0.0;
+        for (auto threads : threads_list) {
+            auto setting = Setting{threads, length, N, maxdim};
+            auto elapsed = cl::with_clock_order(N, [&](auto order) {
+                    return scan_time<decltype(order)::value>(setting, n_points);
+                });
+            double rate = n_points / elapsed * 3600.0;
+            if (threads == 1)
+                serial_rate = rate;
+
+            std::string line = "{";
+            auto field = [&line](const std::string & key, double value) {
+                if (line.size() > 1)
+                    line += ", ";
+                line += "\"" + key + "\": ";
+                ut::append_number(line, value, 6);
+            };
+            field("threads", threads);
+            field("length", length);
+            field("N", N);
+            field("maxdim", maxdim);
+            field("points", n_points);
+            field("seconds", elapsed);
+            field("points_per_hour", rate);
+            field("efficiency", rate / (threads * serial_rate));
+            line += ", \"phases\": {";
+            for (std::size_t n = 0; n < phases.size(); n++) {
+                line += (n > 0 ? ", \"" : "\"") + phases[n].first + "\": ";
+                ut::append_number(line, phases[n].second, 6);
+            }
+            line += "}}";
+
+            file << (first ? "  " : ",\n  ") << line << std::flush;
+            std::cout << line << "\n";
+            first = false;
+        }
+    }
+    file << "\n]\n";
+    std::cout << "Results written onto '" << results << "'\n";
+    return 0;
+}
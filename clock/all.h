@@ -11,6 +11,9 @@
 // Hamiltonian
 #include "hamiltonian.h"
 
+// Operators of all the sites, built once
+#include "siteops.h"
+
 // Order operator (magnetization, local order parameters)
 #include "order.h"
 
@@ -23,8 +26,53 @@
 // Entanglement entropy
 #include "entropy.h"
 
+// Fidelity between neighbouring ground states
+#include "fidelity.h"
+
+// Sweep schedules helpers
+#include "sweeps.h"
+
+// On-disk archive of MPS
+#include "store.h"
+
+// Content-addressed cache of results
+#include "cache.h"
+
+// Checkpoints of scans and DMRG states
+#include "checkpoint.h"
+
+// Work queue shared by several processes
+#include "queue.h"
+
+// Real-space parallel DMRG
+#include "pdmrg.h"
+
+// Single-site DMRG with subspace expansion
+#include "dmrg1.h"
+
+// Correction vectors of the linear response
+#include "response.h"
+
+// Exact diagonalization of small chains
+#include "ed.h"
+
+// Real-time evolution, TEBD and TDVP
+#include "evolution.h"
+
+// Finite temperature by METTS
+#include "metts.h"
+
 // Simulation stuff
 #include "simulations.h"
+
+// Scheduling of whole campaigns of scans
+#include "campaign.h"
+
+// Runtime choice of the clock order
+#include "dispatch.h"
+
+// Precompiled templates for the orders of dispatch.h
+#include "instantiations.h"
 /************************************************************/
 
 #endif
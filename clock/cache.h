@@ -0,0 +1,92 @@
+#ifndef __CLOCK_CACHE_H
+#define __CLOCK_CACHE_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <optional>
+#include <filesystem>
+#include <thread>
+#include <functional>
+
+#include <unistd.h>
+
+#include "types.h"
+#include "../utils/hash.h"
+
+/************************************************************/
+namespace clocks {
+
+///
+/// Content-addressed cache of the results of single points.
+/// Each entry is a file named after the hash of all the inputs of the
+/// point, containing one line "<column> <value>" per result.
+/// Entries are written to a temporary file and then renamed, so that
+/// a killed run never leaves a partial entry behind.
+///
+class ResultCache {
+    std::filesystem::path dir;
+
+public:
+    // Results of a point, as pairs (column id, value)
+    using Row = std::vector<std::pair<string, double>>;
+
+    ResultCache(const string & directory) : dir(directory) {
+        std::filesystem::create_directories(dir);
+    }
+
+    /// Load the results stored under the given hash, if any,
+    /// skipping the malformed lines
+    std::optional<Row> load(const string & hash) const;
+
+    /// Store the results under the given hash
+    void save(const string & hash, const Row & row) const;
+};
+
+/************************************************************/
+
+inline std::optional<ResultCache::Row>
+ResultCache::load(const string & hash) const {
+    std::ifstream file{dir / (hash + ".row")};
+    if (!file)
+        return std::nullopt;
+
+    // strtod, unlike operator>>, reads back the nan and inf of exact_str
+    Row row{};
+    string line, id, token;
+    while (std::getline(file, line)) {
+        std::istringstream fields{line};
+        if (!(fields >> id >> token))
+            continue;
+        char * end = nullptr;
+        double value = std::strtod(token.c_str(), &end);
+        if (end != token.c_str() + token.size())
+            continue;
+        row.emplace_back(id, value);
+    }
+    return row;
+}
+
+inline void
+ResultCache::save(const string & hash, const Row & row) const {
+    // unique among the threads and the processes, also on other
+    // hosts when the cache is on a shared filesystem
+    char host[256] = "";
+    ::gethostname(host, sizeof(host) - 1);
+    auto thread_id = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    auto tmp = dir / (hash + ".tmp." + host + "_" + std::to_string(::getpid())
+                      + "_" + std::to_string(thread_id));
+    {
+        std::ofstream file{tmp};
+        for (const auto & [id, value] : row)
+            file << id << " " << utils::exact_str(value) << "\n";
+    }
+    std::filesystem::rename(tmp, dir / (hash + ".row"));
+}
+
+}
+
+#endif
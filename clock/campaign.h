@@ -0,0 +1,519 @@
+#ifndef __CLOCK_CAMPAIGN_H
+#define __CLOCK_CAMPAIGN_H
+
+#include <map>
+#include <cmath>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include "itensor/all.h"
+#include "simulations.h"
+#include "queue.h"
+
+/************************************************************/
+namespace clocks::simulations {
+
+///
+/// Cost model of a single point, refined with the measured times.
+/// The a priori estimate is L * chi^3 * (1 + number of excited levels);
+/// once points of the same class (N, L, chi, excited levels) have been
+/// timed, their average time is used instead, and the remaining classes
+/// are rescaled by the overall ratio between measured and estimated costs.
+/// The measurements are kept in a telemetry file across runs.
+///
+class CostModel {
+    struct Record {
+        double seconds = 0.0;   // total measured time
+        double model   = 0.0;   // total a priori estimate
+        unsigned count = 0;
+    };
+    std::map<string, Record> records{};
+    string filename;
+    std::mutex mtx;
+
+public:
+    CostModel(const string & filename_ = "") : filename(filename_) { load(); }
+
+    /// Class of a point, points in the same class have the same cost
+    static string key(unsigned N, unsigned length, int maxdim, unsigned n_excited) {
+        return str(N) + "_" + str(length) + "_" + str(maxdim) + "_" + str(n_excited);
+    }
+
+    /// A priori estimate
+    static double model(unsigned length, int maxdim, unsigned n_excited) {
+        return double(length) * std::pow(double(maxdim), 3) * double(1 + n_excited);
+    }
+
+    /// Estimated cost of a point, in seconds once some telemetry is available
+    double estimate(const string & key, double model_cost);
+
+    /// Record the measured time of a point
+    void record(const string & key, double model_cost, double seconds);
+
+    /// Write the telemetry file
+    void save();
+
+private:
+    void load();
+};
+
+
+///
+/// Memory model of a single point, refined with the measured peak RSS.
+/// The a priori estimate is ComputeObservables::memory_estimate_mb; the
+/// measured peak of the process is split among the points in flight in
+/// proportion to their estimates, and the largest share seen for a class
+/// replaces its estimate. Classes not measured yet are rescaled by the
+/// largest ratio between measured and estimated memory.
+///
+class MemoryModel {
+    struct Record {
+        double peak_mb  = 0.0;  // largest measured share
+        double model_mb = 0.0;  // a priori estimate
+    };
+    std::map<string, Record> records{};
+    string filename;
+    std::mutex mtx;
+
+public:
+    MemoryModel(const string & filename_ = "") : filename(filename_) { load(); }
+
+    /// Estimated memory of a point, in MB
+    double estimate(const string & key, double model_mb);
+
+    /// Record the measured memory of a point, in MB
+    void record(const string & key, double model_mb, double measured_mb);
+
+    /// Write the telemetry file
+    void save();
+
+private:
+    void load();
+};
+
+
+///
+/// Scheduler for a whole campaign of scans.
+/// Every point of every scan is a task; the tasks are sorted by estimated
+/// cost and run longest-first on all the threads, so that the expensive
+/// points of the longest chains do not end up alone at the end.
+/// The results are routed back to the table of their scan, which is
+/// written to its csv file as soon as its last point is done.
+/// With a memory budget a point starts only once its estimated memory
+/// fits, together with the points already running.
+///
+/// For campaigns larger than one process the tasks can instead be written
+/// to a WorkQueue (enqueue), computed by any number of worker processes
+/// running the same campaign (work), whose results are exchanged through
+/// the result cache in the queue directory, and finally collected into
+/// the csv files (merge), which fails if a point is missing from the
+/// cache. The cache of the queue replaces the "CachePath" of the scans.
+/// The per-scan "Checkpoint" and "StreamFile" files are not shared
+/// between processes, and are meant for run() only.
+///
+template<unsigned N, unsigned n_excited = 1>
+class Campaign {
+    using Computation = ComputeObservables<N, n_excited>;
+
+    struct Job {
+        Computation computation;
+        unsigned sector;
+        string filename;
+        std::unique_ptr<typename Computation::Scan> scan{};
+        std::atomic<unsigned> remaining{0};
+        std::once_flag started{};
+    };
+
+    struct Task {
+        Job * job;
+        unsigned row;
+        string key;
+        double model;
+        double estimate;
+        ut::ThreadPlan plan;
+        double memory_model;
+        double memory;
+    };
+
+    std::vector<std::unique_ptr<Job>> jobs{};
+    it::Args args;
+    CostModel costs;
+    MemoryModel memory;
+    ut::MemoryBudget budget;
+    double baseline_rss = 0.0;
+
+public:
+    /// Args: "Telemetry" file for the cost model, "Precision" of the csv files,
+    /// "TaskThreads" number of concurrent points (0 for automatic),
+    /// "MemoryBudget" in MB (0 for no limit) and "MemoryTelemetry" file
+    Campaign(const it::Args & args_ = {}) :
+        args(args_),
+        costs(args_.getString("Telemetry", "")),
+        memory(args_.getString("MemoryTelemetry", "")),
+        budget(args_.getReal("MemoryBudget", 0.)) {}
+
+    /// Add the scan of the given couplings, to be written on filename
+    void add(
+        unsigned length,
+        const it::Sweeps & sweeps,
+        const std::vector<double> & couplings,
+        unsigned sector,
+        const string & filename,
+        const it::Args & job_args = {}
+    );
+
+    /// Run all the scans
+    void run();
+
+    /// Write all the points to a new work queue in the given directory
+    void enqueue(const string & dir);
+
+    /// Compute the points of the queue until none is left to claim
+    void work(const string & dir);
+
+    /// Write the csv files from the results of a completed queue
+    void merge(const string & dir);
+
+private:
+    std::vector<Task> tasks();
+    unsigned n_workers(const std::vector<Task> & list);
+    void run_task(const Task & task, unsigned workers);
+    void use_queue_cache(const string & dir);
+    string signature();
+};
+
+/************************************************************/
+
+inline double
+CostModel::estimate(const string & key, double model_cost) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto found = records.find(key);
+    if (found != records.end() && found->second.count > 0)
+        return found->second.seconds / found->second.count;
+
+    double seconds = 0.0, model_total = 0.0;
+    for (const auto & [k, rec] : records) {
+        seconds     += rec.seconds;
+        model_total += rec.model;
+    }
+    if (model_total > 0.0)
+        return model_cost * seconds / model_total;
+    return model_cost;
+}
+
+inline void
+CostModel::record(const string & key, double model_cost, double seconds) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto & rec = records[key];
+    rec.seconds += seconds;
+    rec.model   += model_cost;
+    rec.count   += 1;
+}
+
+inline void
+CostModel::load() {
+    if (filename.empty())
+        return;
+    std::ifstream file{filename};
+    string key;
+    Record rec;
+    while (file >> key >> rec.seconds >> rec.model >> rec.count)
+        records[key] = rec;
+}
+
+inline void
+CostModel::save() {
+    if (filename.empty())
+        return;
+    std::lock_guard<std::mutex> lock(mtx);
+    std::ofstream file{filename, std::ios::trunc};
+    for (const auto & [key, rec] : records)
+        file << key << " " << ut::exact_str(rec.seconds) << " "
+             << ut::exact_str(rec.model) << " " << rec.count << "\n";
+}
+
+
+inline double
+MemoryModel::estimate(const string & key, double model_mb) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto found = records.find(key);
+    if (found != records.end())
+        return found->second.peak_mb;
+
+    double ratio = 0.0;
+    for (const auto & [k, rec] : records)
+        ratio = std::max(ratio, rec.peak_mb / rec.model_mb);
+    return ratio > 0.0 ? model_mb * ratio : model_mb;
+}
+
+inline void
+MemoryModel::record(const string & key, double model_mb, double measured_mb) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto & rec = records[key];
+    rec.peak_mb  = std::max(rec.peak_mb, measured_mb);
+    rec.model_mb = model_mb;
+}
+
+inline void
+MemoryModel::load() {
+    if (filename.empty())
+        return;
+    std::ifstream file{filename};
+    string key;
+    Record rec;
+    while (file >> key >> rec.peak_mb >> rec.model_mb)
+        records[key] = rec;
+}
+
+inline void
+MemoryModel::save() {
+    if (filename.empty())
+        return;
+    std::lock_guard<std::mutex> lock(mtx);
+    std::ofstream file{filename, std::ios::trunc};
+    for (const auto & [key, rec] : records)
+        file << key << " " << ut::exact_str(rec.peak_mb) << " "
+             << ut::exact_str(rec.model_mb) << "\n";
+}
+
+
+template<unsigned N, unsigned n_excited>
+void
+Campaign<N, n_excited>::add(
+    unsigned length,
+    const it::Sweeps & sweeps,
+    const std::vector<double> & couplings,
+    unsigned sector,
+    const string & filename,
+    const it::Args & job_args
+) {
+    jobs.push_back(std::unique_ptr<Job>(new Job{
+            Computation(length, sweeps, couplings, job_args),
+            sector,
+            filename
+        }));
+}
+
+template<unsigned N, unsigned n_excited>
+std::vector<typename Campaign<N, n_excited>::Task>
+Campaign<N, n_excited>::tasks() {
+    std::vector<Task> list{};
+    for (auto & job : jobs) {
+        auto & comp = job->computation;
+        int maxdim = cl::max_dim(comp.sweeps);
+        unsigned n_levels = comp.args.getBool("NoExcited", false) ? 0 : n_excited;
+
+        auto key   = CostModel::key(N, comp.size, maxdim, n_levels);
+        auto model = CostModel::model(comp.size, maxdim, n_levels);
+        auto estimate = costs.estimate(key, model);
+        auto plan = comp.thread_plan();
+        auto memory_model = comp.memory_estimate_mb();
+        auto memory_estimate = memory.estimate(key, memory_model);
+        for (auto row : ut::range(unsigned(comp.couplings.size())))
+            list.push_back(Task{
+                    job.get(), row, key, model, estimate, plan, memory_model, memory_estimate
+                });
+    }
+
+    // Longest processing time first
+    std::stable_sort(list.begin(), list.end(),
+            [](const Task & a, const Task & b){ return a.estimate > b.estimate; });
+    return list;
+}
+
+template<unsigned N, unsigned n_excited>
+unsigned
+Campaign<N, n_excited>::n_workers(const std::vector<Task> & list) {
+    // Workers sized on the most expensive tasks, which run first; each
+    // task then sets its own BLAS threads (per thread with MKL), clamped
+    // to the fixed slice of cores of its worker
+    unsigned workers = args.getInt("TaskThreads", 0);
+    if (workers == 0 && !list.empty())
+        workers = ut::make_thread_plan(0, list.front().plan.blas_threads, false).workers;
+    return std::max(workers, 1u);
+}
+
+template<unsigned N, unsigned n_excited>
+void
+Campaign<N, n_excited>::run_task(const Task & task, unsigned workers) {
+    auto & job = *task.job;
+    std::call_once(job.started, [&job]{
+            job.scan = job.computation.begin_scan(job.sector);
+        });
+    // each worker owns a fixed slice of the cores, whatever the task
+    ut::ScopedThreadPlan applied(ut::in_worker_slice(task.plan, workers), ut::thread_id());
+
+    budget.acquire(task.memory);
+    auto point_timer = ut::Timer().start();
+    ut::RssSampler sampler{};
+    auto computed = job.computation.compute_row(*job.scan, task.row);
+    point_timer.stop();
+    if (computed) {
+        costs.record(task.key, task.model, point_timer.duration<ut::time::ms>() / 1000.0);
+        // share of the peak during the point, among those in flight
+        auto share = (sampler.peak_mb() - baseline_rss) * task.memory / budget.reserved();
+        if (share > 0.0)
+            memory.record(task.key, task.memory_model, share);
+    }
+    budget.release(task.memory);
+}
+
+template<unsigned N, unsigned n_excited>
+void
+Campaign<N, n_excited>::run() {
+    for (auto & job : jobs)
+        job->remaining = job->computation.couplings.size();
+    auto list = tasks();
+    unsigned n_tasks = list.size(), step = 0;
+    auto precision = args.getInt("Precision", 12);
+    auto workers = n_workers(list);
+    auto timer = ut::Timer().start();
+    baseline_rss = ut::rss_mb();
+
+    std::cout << " * Campaign of " << jobs.size() << " scans, "
+              << n_tasks << " points on " << workers << " workers\n";
+
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(workers)
+    for (auto n : ut::range(n_tasks)) {
+        auto & task = list.at(n);
+        auto & job  = *task.job;
+        #pragma omp critical
+        {
+            std::cout << "\033[2K\r"
+                << "   In progress [" << ++step << "/" << n_tasks << "]"
+                << std::flush;
+        }
+        run_task(task, workers);
+
+        // The last point of a scan writes its results
+        if (--job.remaining == 0) {
+            auto results = job.computation.finish_scan(*job.scan);
+            results.set_precision(precision).to_csv(job.filename);
+            job.scan.reset();
+        }
+    }
+    costs.save();
+    memory.save();
+    std::cout << " Done!\n";
+    std::cout << "   Elapsed time: " << timer.stop() << "\n";
+}
+
+template<unsigned N, unsigned n_excited>
+string
+Campaign<N, n_excited>::signature() {
+    string hashes{};
+    for (auto & job : jobs) {
+        hashes += job->filename + "\n";
+        for (auto coupling : job->computation.couplings)
+            hashes += job->computation.point_hash(coupling, job->sector) + "\n";
+    }
+    return ut::to_hex(ut::fnv1a(hashes));
+}
+
+template<unsigned N, unsigned n_excited>
+void
+Campaign<N, n_excited>::use_queue_cache(const string & dir) {
+    // the results of the workers are exchanged through the result cache
+    // of the queue, which replaces the own cache of each scan
+    for (auto & job : jobs)
+        job->computation.args.add("CachePath", dir + "/results");
+}
+
+template<unsigned N, unsigned n_excited>
+void
+Campaign<N, n_excited>::enqueue(const string & dir) {
+    std::map<const Job *, unsigned> index{};
+    for (auto n : ut::range(unsigned(jobs.size())))
+        index[jobs[n].get()] = n;
+
+    // tasks as "<job> <row>", longest first
+    std::vector<string> descriptions{};
+    for (const auto & task : tasks())
+        descriptions.push_back(str(index.at(task.job)) + " " + str(task.row));
+    cl::WorkQueue::create(dir, descriptions, signature());
+    std::cout << " * Queued " << descriptions.size() << " points of "
+              << jobs.size() << " scans in '" << dir << "'\n";
+}
+
+template<unsigned N, unsigned n_excited>
+void
+Campaign<N, n_excited>::work(const string & dir) {
+    auto queue = cl::WorkQueue(dir);
+    if (queue.signature() != signature())
+        throw std::runtime_error("Work queue '" + dir + "' belongs to a different campaign");
+    use_queue_cache(dir);
+
+    // Tasks by (job, row), with their cost and memory estimates
+    std::map<pair<const Job *, unsigned>, Task> by_point{};
+    auto list = tasks();
+    for (const auto & task : list)
+        by_point.emplace(std::make_pair(task.job, task.row), task);
+
+    auto workers = n_workers(list);
+    auto timer = ut::Timer().start();
+    std::atomic<unsigned> n_computed{0};
+    baseline_rss = ut::rss_mb();
+
+    std::cout << " * Worker on queue '" << dir << "', "
+              << queue.n_done() << "/" << queue.size() << " points done, "
+              << workers << " threads\n";
+
+    #pragma omp parallel num_threads(workers)
+    {
+        while (auto claim = queue.claim()) {
+            std::istringstream description{claim->description()};
+            unsigned job_id, row;
+            description >> job_id >> row;
+            run_task(by_point.at({jobs.at(job_id).get(), row}), workers);
+            queue.complete(claim.value());
+
+            #pragma omp critical
+            {
+                std::cout << "\033[2K\r"
+                    << "   Computed " << ++n_computed << " points"
+                    << std::flush;
+            }
+        }
+    }
+    costs.save();
+    memory.save();
+    std::cout << " Done!\n";
+    std::cout << "   Elapsed time: " << timer.stop() << "\n";
+}
+
+template<unsigned N, unsigned n_excited>
+void
+Campaign<N, n_excited>::merge(const string & dir) {
+    auto queue = cl::WorkQueue(dir);
+    if (queue.signature() != signature())
+        throw std::runtime_error("Work queue '" + dir + "' belongs to a different campaign");
+    if (queue.n_done() < queue.size())
+        throw std::runtime_error(
+                "Work queue '" + dir + "' not completed: "
+                + str(queue.n_done()) + "/" + str(queue.size()) + " points done"
+            );
+    use_queue_cache(dir);
+
+    // every point is in the cache, the scans only collect the results
+    // (and the fidelities, from the states of a shared "StorePath"):
+    // a missing point is an error, not a silent recomputation
+    auto precision = args.getInt("Precision", 12);
+    for (auto & job : jobs) {
+        job->computation.args.add("CacheOnly", true);
+        auto scan = job->computation.begin_scan(job->sector);
+        for (auto row : ut::range(unsigned(job->computation.couplings.size())))
+            job->computation.compute_row(*scan, row);
+        auto results = job->computation.finish_scan(*scan);
+        results.set_precision(precision).to_csv(job->filename);
+    }
+}
+
+}
+
+#endif
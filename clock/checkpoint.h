@@ -0,0 +1,200 @@
+#ifndef __CLOCK_CHECKPOINT_H
+#define __CLOCK_CHECKPOINT_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <optional>
+#include <stdexcept>
+#include <filesystem>
+
+#include "itensor/all.h"
+#include "types.h"
+#include "../utils/hash.h"
+
+/************************************************************/
+namespace clocks {
+
+///
+/// Completed rows of a scan, appended to a file as soon as they are done.
+/// The file starts with a "# <signature>" line identifying the scan and
+/// a header "row,<ids...>", followed by one line per completed row.
+/// Rows written by a previous run of the same scan are restored when
+/// the checkpoint is opened, otherwise the file is started anew.
+///
+class RowCheckpoint {
+    std::vector<string> ids;
+    std::map<unsigned, std::vector<double>> restored_;
+    std::ofstream file;
+    std::mutex mtx;
+
+public:
+    RowCheckpoint(
+        const string & filename,
+        const string & signature,
+        const std::vector<string> & ids_
+    );
+
+    /// Values of a row completed by a previous run, in the order of the ids
+    std::optional<std::vector<double>> restored(unsigned row) const;
+    std::size_t n_restored() const { return restored_.size(); }
+
+    /// Append a completed row, flushed immediately
+    void save(unsigned row, const std::vector<double> & values);
+
+private:
+    string header() const;
+    void restore(const string & filename, const string & signature);
+};
+
+
+/// Save the MPS reached after the given sweep, next to the checkpoint
+inline void save_partial_state(const string & base, const it::MPS & psi, int sweep);
+
+/// Load the MPS and the number of completed sweeps, if any
+inline std::optional<std::pair<it::MPS, int>> load_partial_state(const string & base);
+
+/// Remove the partial state once the DMRG is complete
+inline void remove_partial_state(const string & base);
+
+///
+/// DMRG observer saving the state at the end of each sweep
+/// (the sweeps are counted from offset, for resumed calculations)
+///
+class CheckpointObserver : public it::DMRGObserver {
+    string base;
+    int offset;
+
+public:
+    CheckpointObserver(
+        const it::MPS & psi,
+        const string & base_,
+        int offset_ = 0,
+        const it::Args & args = it::Args::global()
+    ) : it::DMRGObserver(psi, args), base(base_), offset(offset_) {}
+
+    bool checkDone(const it::Args & args = it::Args::global()) override {
+        auto done = it::DMRGObserver::checkDone(args);
+        save_partial_state(base, psi(), offset + args.getInt("Sweep"));
+        return done;
+    }
+};
+
+/************************************************************/
+
+inline
+RowCheckpoint::RowCheckpoint(
+    const string & filename,
+    const string & signature,
+    const std::vector<string> & ids_
+) : ids(ids_) {
+    restore(filename, signature);
+
+    if (restored_.empty()) {
+        file.open(filename, std::ios::out | std::ios::trunc);
+        file << "# " << signature << "\n" << header() << std::endl;
+    } else {
+        file.open(filename, std::ios::out | std::ios::app);
+    }
+}
+
+inline string
+RowCheckpoint::header() const {
+    string line = "row";
+    for (const auto & id : ids)
+        line += "," + id;
+    return line;
+}
+
+inline void
+RowCheckpoint::restore(const string & filename, const string & signature) {
+    std::ifstream input{filename};
+    string line;
+    if (!std::getline(input, line) || line != "# " + signature)
+        return;
+    if (!std::getline(input, line) || line != header())
+        return;
+
+    while (std::getline(input, line)) {
+        // a last line without newline was truncated by a killed job
+        if (input.eof())
+            break;
+        std::istringstream fields{line};
+        string cell;
+        std::vector<double> values{};
+        values.reserve(ids.size());
+        if (!std::getline(fields, cell, ','))
+            continue;
+        // a corrupted row is not done, and is computed again
+        unsigned long row;
+        try {
+            std::size_t end;
+            row = std::stoul(cell, &end);
+            if (end != cell.size())
+                continue;
+        } catch (const std::logic_error &) {
+            continue;
+        }
+        bool valid = true;
+        while (valid && std::getline(fields, cell, ',')) {
+            char * end;
+            values.push_back(std::strtod(cell.c_str(), &end));
+            valid = !cell.empty() && *end == '\0';
+        }
+        if (valid && values.size() == ids.size())
+            restored_[row] = values;
+    }
+}
+
+inline std::optional<std::vector<double>>
+RowCheckpoint::restored(unsigned row) const {
+    auto found = restored_.find(row);
+    if (found == restored_.end())
+        return std::nullopt;
+    return found->second;
+}
+
+inline void
+RowCheckpoint::save(unsigned row, const std::vector<double> & values) {
+    std::ostringstream line;
+    line << row;
+    for (auto value : values)
+        line << "," << utils::exact_str(value);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    file << line.str() << std::endl;
+}
+
+
+inline void
+save_partial_state(const string & base, const it::MPS & psi, int sweep) {
+    // write then rename, a killed job leaves the previous state intact
+    it::writeToFile(base + ".mps.tmp", psi);
+    std::filesystem::rename(base + ".mps.tmp", base + ".mps");
+    std::ofstream{base + ".sweep"} << sweep << std::endl;
+}
+
+inline std::optional<std::pair<it::MPS, int>>
+load_partial_state(const string & base) {
+    std::ifstream sweep_file{base + ".sweep"};
+    int sweep = 0;
+    if (!(sweep_file >> sweep) || !std::filesystem::exists(base + ".mps"))
+        return std::nullopt;
+    auto psi = it::readFromFile<it::MPS>(base + ".mps");
+    return std::make_pair(psi, sweep);
+}
+
+inline void
+remove_partial_state(const string & base) {
+    std::filesystem::remove(base + ".mps");
+    std::filesystem::remove(base + ".sweep");
+}
+
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define __CLOCK_CLASS_H
 
 #include <cmath>
+#include <string>
 #include "itensor/all.h"
 #include "types.h"
 
@@ -40,6 +41,16 @@ inline bool is_valid_op(const string & op){
     return op == "X" || op == "Xdag" || op == "Z" || op == "Zdag";
 }
 
+/// Name of the n-th state of ClockSite<N> (n = 0, ..., N-1), i.e. of
+/// the index value n+1: "n", but "Up" and "Dn" for N = 2
+template<unsigned N>
+string state_name(unsigned n) {
+    if constexpr (N == 2)
+        return n == 0 ? "Up" : "Dn";
+    else
+        return std::to_string(n);
+}
+
 /************************************************************/
 
 ///
@@ -1,7 +1,10 @@
 #ifndef __CLOCK_CORRELATOR_H
 #define __CLOCK_CORRELATOR_H
 
+#include <vector>
+
 #include "clock.h"
+#include "siteops.h"
 
 /************************************************************/
 namespace clocks {
@@ -36,8 +39,83 @@ compute_correlatorC(
     const Interval & interv
 );
 
+// Same, with the operators of the site set built beforehand
+template<unsigned int N>
+complex
+compute_correlatorC(
+    const SiteOps<N> & ops,
+          it::MPS    & psi,
+    const string     & op1,
+    const string     & op2,
+    const Interval   & interv
+);
+
+// Correlators <op1(begin) op2(end)> for all the end in (begin, last],
+// extending a single environment from begin to last, instead of one
+// contraction from begin for each distance
+template<unsigned int N>
+std::vector<complex>
+compute_correlatorsC(
+    const SiteOps<N> & ops,
+          it::MPS    & psi,
+    const string     & op1,
+    const string     & op2,
+    int begin,
+    int last
+);
+
 /************************************************************/
 
+namespace detail {
+
+// Environment of the correlator from the start of the interval,
+// with the ket and the primed bra links on the right of begin
+template<typename Ops>
+it::ITensor correlator_start(const Ops & op_at, it::MPS & psi, const string & op1, int begin) {
+    psi.position(begin);
+    it::ITensor correl = psi(begin);
+    // Contracts the operator at the start of the interval
+    correl *= op_at(op1, begin);
+
+    // find the right link index of the bra <psi|
+    // Primes both the site index and the link index and then contracts
+    correl *= dag(utils::prime_inds(psi(begin), "Site", it::rightLinkIndex(psi, begin)));
+    return correl;
+}
+
+// Extends the environment through site i, one tensor at a time so
+// that no intermediate with both the ket and bra links of i is built
+inline void correlator_extend(it::ITensor & correl, const it::MPS & psi, int i) {
+    correl *= psi(i);
+    correl *= dag(prime(psi(i), "Link"));
+}
+
+// Contracts the operator at the end of the interval, returning a scalar
+template<typename Ops>
+it::ITensor correlator_close(
+    const it::ITensor & correl,
+    const Ops & op_at,
+    const it::MPS & psi,
+    const string & op2,
+    int end
+) {
+    auto closed = correl * psi(end);
+    closed *= op_at(op2, end);
+
+    // find the left index of the bra <psi| and then contracts with evaluated correlator
+    closed *= dag(utils::prime_inds(psi(end), "Site", it::leftLinkIndex(psi, end)));
+    return closed;
+}
+
+inline void check_correlator_ops(const string & op1, const string & op2) {
+    if (!is_valid_op(op1))
+        throw std::runtime_error("Unrecognized first operator for correlator");
+    if (!is_valid_op(op2))
+        throw std::runtime_error("Unrecognized second operator for correlator");
+}
+
+}
+
 // Compute the correlation function
 // return a scalar ITensor
 template<unsigned int N>
@@ -48,41 +126,22 @@ it::ITensor compute_correlator_IT(
     const string   & op2,
     const Interval & interv
 ) {
-    if (!is_valid_op(op1))
-        throw std::runtime_error("Unrecognized first operator for correlator");
-    if (!is_valid_op(op2))
-        throw std::runtime_error("Unrecognized second operator for correlator");
+    detail::check_correlator_ops(op1, op2);
 
     int L = length(sites);
     auto [begin, end] = interv;
     if (begin < 0 || end > L || begin >= end)
         throw std::runtime_error("Incorrect position for correlator");
 
-    auto op_first  = op(sites, op1, begin);
-    auto op_second = op(sites, op2, end);
-
-    psi.position(begin);
-    it::ITensor correl = psi(begin);
-    // Contracts the operator at the start of the interval
-    correl *= op_first;
-
-    // find the right link index of the bra <psi|
-    // Primes both the site index and the link index and then contracts
-    correl *= dag(utils::prime_inds(psi(begin), "Site", it::rightLinkIndex(psi, begin)));
+    auto op_at = [&sites](const string & name, int i) { return op(sites, name, i); };
+    auto correl = detail::correlator_start(op_at, psi, op1, begin);
 
     // Contracts all the site inside the interval
     for (int i=begin+1; i<end; i++)
-        correl *= psi(i) * dag(prime(psi(i), "Link"));
+        detail::correlator_extend(correl, psi, i);
 
     // Contract the operators at the end of the interval
-    correl *= psi(end);
-    correl *= op_second;
-
-    // find the left index of the bra <psi| and then contracts with evaluated correlator
-    correl *= dag(utils::prime_inds(psi(end), "Site", it::leftLinkIndex(psi, end)));
-    // Contracts all the site at the right of the interval
-
-    return correl;
+    return detail::correlator_close(correl, op_at, psi, op2, end);
 }
 
 template<unsigned int N>
@@ -107,6 +166,49 @@ complex compute_correlatorC(
     return eltC(compute_correlator_IT(sites, psi, op1, op2, interv));
 }
 
+template<unsigned int N>
+complex compute_correlatorC(
+    const SiteOps<N> & ops,
+          it::MPS    & psi,
+    const string     & op1,
+    const string     & op2,
+    const Interval   & interv
+) {
+    detail::check_correlator_ops(op1, op2);
+    auto [begin, end] = interv;
+    if (begin < 1 || end > ops.length() || begin >= end)
+        throw std::runtime_error("Incorrect position for correlator");
+
+    auto correl = detail::correlator_start(ops, psi, op1, begin);
+    for (int i=begin+1; i<end; i++)
+        detail::correlator_extend(correl, psi, i);
+    return eltC(detail::correlator_close(correl, ops, psi, op2, end));
+}
+
+template<unsigned int N>
+std::vector<complex> compute_correlatorsC(
+    const SiteOps<N> & ops,
+          it::MPS    & psi,
+    const string     & op1,
+    const string     & op2,
+    int begin,
+    int last
+) {
+    detail::check_correlator_ops(op1, op2);
+    if (begin < 1 || last > ops.length() || begin >= last)
+        throw std::runtime_error("Incorrect position for correlator");
+
+    std::vector<complex> values{};
+    values.reserve(last - begin);
+    auto correl = detail::correlator_start(ops, psi, op1, begin);
+    for (int end = begin+1; end <= last; end++) {
+        values.push_back(eltC(detail::correlator_close(correl, ops, psi, op2, end)));
+        if (end < last)
+            detail::correlator_extend(correl, psi, end);
+    }
+    return values;
+}
+
 
 }
 #endif
@@ -3,6 +3,7 @@
 
 #include "clock.h"
 #include "types.h"
+#include "siteops.h"
 #include "../utils/all.h"
 
 /************************************************************/
@@ -37,13 +38,25 @@ compute_disorderC(
     const utils::Interval & interv
 );
 
+// Same, with the operators of the site set built beforehand
+template<unsigned int N>
+complex
+compute_disorderC(
+    const SiteOps<N> & ops,
+    it::MPS   &    psi,
+    const string   & op_type,
+    const utils::Interval & interv
+);
+
 /************************************************************/
 
-// Compute disorder parameter
-// Return a scalar ITensor
-template<unsigned int N>
-it::ITensor compute_disorder_IT(
-    const Clock<N> & sites,
+namespace detail {
+
+// Disorder operator with the site operators from op_at(name, site)
+template<typename Ops>
+it::ITensor disorder_IT(
+    const Ops & op_at,
+    int L,
     it::MPS & psi,
     const string & op_type,
     const utils::Interval & interv
@@ -51,7 +64,6 @@ it::ITensor compute_disorder_IT(
     if (!is_valid_op(op_type))
         throw std::runtime_error("Unrecognized operator for disorder operator");
 
-    int L = length(sites);
     auto [begin, end] = interv;
     if (begin < 0 || end > L || begin >= end)
         throw std::runtime_error("Incorrect range for disorder operator");
@@ -59,22 +71,37 @@ it::ITensor compute_disorder_IT(
     psi.position(begin);
 
     it::ITensor disorder = psi(begin);
-    disorder *= op(sites, op_type, begin);
+    disorder *= op_at(op_type, begin);
     disorder *= dag(utils::prime_inds(psi(begin), "Site", it::rightLinkIndex(psi, begin)));
 
     for(int pos=begin+1; pos < end; pos++) {
         disorder *= psi(pos);
-        disorder *= op(sites, op_type, pos);
+        disorder *= op_at(op_type, pos);
         disorder *= dag(utils::prime_inds(psi(pos), "Site", "Link"));
     }
 
     disorder *= psi(end);
-    disorder *= op(sites, op_type, end);
+    disorder *= op_at(op_type, end);
     disorder *= dag(utils::prime_inds(psi(end), "Site", it::leftLinkIndex(psi, end)));
 
     return disorder;
 }
 
+}
+
+// Compute disorder parameter
+// Return a scalar ITensor
+template<unsigned int N>
+it::ITensor compute_disorder_IT(
+    const Clock<N> & sites,
+    it::MPS & psi,
+    const string & op_type,
+    const utils::Interval & interv
+) {
+    auto op_at = [&sites](const string & name, int i) { return op(sites, name, i); };
+    return detail::disorder_IT(op_at, length(sites), psi, op_type, interv);
+}
+
 template<unsigned int N>
 double compute_disorder(
     const Clock<N> & sites,
@@ -95,5 +122,15 @@ complex compute_disorderC(
     return eltC(compute_disorder_IT(sites, psi, op_type, interv));
 }
 
+template<unsigned int N>
+complex compute_disorderC(
+    const SiteOps<N> & ops,
+    it::MPS & psi,
+    const string & op_type,
+    const utils::Interval & interv
+) {
+    return eltC(detail::disorder_IT(ops, ops.length(), psi, op_type, interv));
+}
+
 }
 #endif
@@ -0,0 +1,43 @@
+#ifndef __CLOCK_DISPATCH_H
+#define __CLOCK_DISPATCH_H
+
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+
+/************************************************************/
+namespace clocks {
+
+/// Clock orders with precompiled templates, see instantiations.h
+inline constexpr unsigned min_clock_order = 2;
+inline constexpr unsigned max_clock_order = 8;
+
+/// Call func with std::integral_constant<unsigned, N>{} for a clock order
+/// N known only at runtime, e.g.
+///     with_clock_order(N, [&](auto order) {
+///         constexpr unsigned N = decltype(order)::value;
+///         ...
+///     });
+/// so that a single binary serves all the precompiled orders.
+/// func has to return the same type for every order
+template<typename F>
+decltype(auto) with_clock_order(unsigned N, F && func) {
+    switch (N) {
+        case 2: return func(std::integral_constant<unsigned, 2>{});
+        case 3: return func(std::integral_constant<unsigned, 3>{});
+        case 4: return func(std::integral_constant<unsigned, 4>{});
+        case 5: return func(std::integral_constant<unsigned, 5>{});
+        case 6: return func(std::integral_constant<unsigned, 6>{});
+        case 7: return func(std::integral_constant<unsigned, 7>{});
+        case 8: return func(std::integral_constant<unsigned, 8>{});
+        default:
+            throw std::invalid_argument(
+                    "Clock order " + std::to_string(N) + " not in "
+                    + std::to_string(min_clock_order) + ".." + std::to_string(max_clock_order)
+                );
+    }
+}
+
+}
+
+#endif
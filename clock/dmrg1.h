@@ -0,0 +1,127 @@
+#ifndef __CLOCK_DMRG1_H
+#define __CLOCK_DMRG1_H
+
+#include <utility>
+
+#include "itensor/all.h"
+#include "types.h"
+#include "sweeps.h"
+#include "environments.h"
+
+/************************************************************/
+namespace clocks {
+
+/// Single-site DMRG with subspace expansion.
+/// The local eigenproblem involves a single site, (chi N)^2 smaller than
+/// the two-site one by a factor N^2, and the bond is moved by diagonalizing
+/// the density matrix of the site perturbed by the action of the MPO
+///     rho = Tr |phi><phi| + alpha Tr |P><P|,   P = L W phi
+/// (White 2005) so that the basis can grow into the directions coupled by
+/// the Hamiltonian and the solver does not get stuck at fixed bond
+/// dimension. alpha is the noise of each sweep, or "Alpha" when zero.
+/// Returns the energy and updates psi, like dmrg(psi, H, sweeps, args)
+inline double
+dmrg1(it::MPS & psi, const it::MPO & H, const it::Sweeps & sweeps, const it::Args & args = {});
+
+/************************************************************/
+
+namespace detail {
+
+///
+/// Single-site sweeps over the site tensors and environments
+///
+class SingleSiteDMRG : public Environments {
+public:
+    SingleSiteDMRG(const it::MPO & H, const it::MPS & psi0) : Environments(H, psi0) {}
+
+    /// Optimize the b-th site and move the center to the right (or left)
+    double step(unsigned b, bool to_right, double alpha, const it::Args & args);
+
+private:
+    it::ITensor density_matrix(
+        const it::ITensor & phi,
+        const it::ITensor & env,
+        unsigned b,
+        unsigned next,
+        double alpha
+    ) const;
+};
+
+
+inline it::ITensor
+SingleSiteDMRG::density_matrix(
+    const it::ITensor & phi,
+    const it::ITensor & env,
+    unsigned b,
+    unsigned next,
+    double alpha
+) const {
+    // the density matrix acts on all the indices but the bond
+    // along which the center moves
+    auto bond = it::commonIndex(M[b], M[next]);
+    auto prime_kept = [&bond](it::ITensor T) {
+        T.prime();
+        T.noPrime(it::prime(bond));
+        return T;
+    };
+    auto rho = phi * it::dag(prime_kept(phi));
+
+    // perturbation, with the MPO link to the next site
+    // traced out together with the bond
+    if (alpha > 0.0) {
+        auto P = it::noPrime(env ? env * phi * W[b] : phi * W[b]);
+        auto Pdag = it::dag(prime_kept(P));
+        for (const auto & link : it::commonInds(W[b], W[next]))
+            Pdag.noPrime(it::prime(link));
+        rho += alpha * P * Pdag;
+    }
+    return rho;
+}
+
+inline double
+SingleSiteDMRG::step(unsigned b, bool to_right, double alpha, const it::Args & args) {
+    auto next = to_right ? b + 1 : b - 1;
+    auto & env = to_right ? LE[b-1] : RE[b+1];
+
+    auto phi = M[b];
+    auto op = it::LocalOp(W[b], LE[b-1], RE[b+1]);
+    auto energy = it::davidson(op, phi, args);
+
+    auto rho = density_matrix(phi, env, b, next, alpha);
+    it::ITensor U, D;
+    it::diagPosSemiDef(rho, U, D, args);
+
+    M[b]    = U;
+    M[next] = (phi * it::dag(U)) * M[next];
+    if (to_right)
+        LE[b] = extend_left(b, U);
+    else
+        RE[b] = extend_right(b, U);
+    return energy;
+}
+
+}
+
+
+inline double
+dmrg1(it::MPS & psi, const it::MPO & H, const it::Sweeps & sweeps, const it::Args & args) {
+    auto solver = detail::SingleSiteDMRG(H, psi);
+    auto length = solver.length;
+
+    double energy = 0.0;
+    for (auto sw : it::range1(sweeps.nsweep())) {
+        auto alpha = sweeps.noise(sw) > 0.0 ? sweeps.noise(sw) : args.getReal("Alpha", 0.);
+        auto step_args = sweep_args(sweeps, sw);
+        for (auto b = 1u; b < length; b++)
+            energy = solver.step(b, true, alpha, step_args);
+        for (auto b = length; b > 1; b--)
+            energy = solver.step(b, false, alpha, step_args);
+    }
+
+    psi = detail::Environments::to_mps(psi, solver.M);
+    return energy;
+}
+
+}
+
+#endif
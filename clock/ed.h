@@ -0,0 +1,760 @@
+#ifndef __CLOCK_ED_H
+#define __CLOCK_ED_H
+
+#include <array>
+#include <cmath>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+#include "itensor/all.h"
+#include "clock.h"
+#include "types.h"
+#include "hamiltonian.h"
+#include "environments.h"
+
+/************************************************************/
+namespace clocks {
+
+/// Vector of the full Hilbert space, in the basis of the configurations
+///     n_1 + N n_2 + N^2 n_3 + ...
+/// of the clock states n_i = 0, ..., N-1 (the i-th state of ClockSite<N>)
+using EDVector = std::vector<complex>;
+
+/// Energy and state of a level
+using EDLevel = std::pair<double, EDVector>;
+
+///
+/// Exact diagonalization of the clock chain, matrix-free, with a thick
+/// restarted Lanczos (full reorthogonalization) in each symmetry sector:
+///  - Z_N charge sum_i n_i mod N, when every term conserves it, i.e.
+///    without the longitudinal field;
+///  - momentum, with PBC, a real kinetic coupling and the same couplings
+///    on every site.
+/// The local operators are read from ClockSite<N>, so the conventions
+/// are the ones of the MPO Hamiltonians and of the measurements.
+/// Options: "EDKrylov" (basis size before a restart, 40), "EDTolerance"
+/// (residual of the Ritz pairs, 1e-10), "EDMaxRestarts" (500), "EDSeed"
+/// (seed of the initial vectors, 1), "EDMaxMemory" (in MB, 4096, see
+/// memory_mb).
+/// A Krylov method started from a single vector finds each degenerate
+/// level only once: the levels of a sector are deflated, i.e. Lanczos
+/// is run again in the complement of the levels found so far, until it
+/// finds no level below the ones already found
+///
+template<unsigned N>
+class ExactChain {
+public:
+    /// A product of single-site operators, as (name, site) with sites from 1
+    using OpString = std::vector<std::pair<string, unsigned>>;
+
+    ExactChain(const SiteCouplings & couplings, const it::Args & args = {});
+
+    /// The same couplings on every site
+    ExactChain(unsigned length, const ChainCouplings & couplings, const it::Args & args = {}) :
+        ExactChain(SiteCouplings(length, couplings), args) {}
+
+    unsigned length() const { return L; }
+    bool charge_conserved() const { return charge_conserved_; }
+    bool translation_invariant() const { return translation_invariant_; }
+
+    /// Lowest n levels over all the symmetry sectors, ascending
+    std::vector<EDLevel> lowest(unsigned n) const;
+
+    /// Estimate in MB of the memory of lowest(n) on a chain of the given
+    /// length, for the worst case of a single sector: the Krylov basis,
+    /// the Ritz vectors and the levels, and the configurations
+    static double memory_mb(unsigned length, unsigned n, const it::Args & args = {});
+
+    /// <bra| O_1 O_2 ... |ket> for a product of single-site operators
+    complex expectation(const EDVector & bra, const OpString & ops, const EDVector & ket) const;
+
+    /// O_1 O_2 ... |ket> for a product of single-site operators
+    EDVector product(const OpString & ops, const EDVector & ket) const;
+
+    /// Correction vector of the ground state gs with the given energy,
+    /// for the perturbed state V|gs> of a Hermitian perturbation V: the
+    /// solution of (H - E0)|x> = - (1 - |gs><gs|) V|gs>, orthogonal to gs,
+    /// by conjugate gradient, so that the second derivative of the
+    /// ground state energy along H + lambda V is 2 Re <gs|V|x> (for a
+    /// non-degenerate ground state). Options: "ResponseTolerance" on the
+    /// relative residual (1e-10) and "ResponseMaxIter" (1000)
+    EDVector correction_vector(const EDVector & gs, double energy, const EDVector & perturbed) const;
+
+    /// State of the full Hilbert space as an MPS on the given sites
+    it::MPS to_mps(const EDVector & state, const Clock<N> & sites) const;
+
+private:
+    using code_t = std::uint64_t;
+
+    /// Single-site operator with a single non-zero element per column,
+    /// n -> (to[n], value[n]), changing the charge by shift (or not charged)
+    struct LocalOp {
+        std::array<unsigned, N> to;
+        std::array<complex, N> value;
+        int shift = 0;
+        bool charged = true;
+    };
+
+    /// coeff times a product of local operators (index in ops_, site)
+    struct Term {
+        complex coeff;
+        std::vector<std::pair<unsigned, unsigned>> factors;
+    };
+
+    /// Basis of a sector: configurations, or representatives of the
+    /// translation orbits with their periods (with momentum)
+    struct Sector {
+        int charge = -1;
+        int momentum = -1;      // k = 2 pi momentum / L
+        std::vector<code_t> states{};
+        std::vector<unsigned> periods{};
+        std::size_t size() const { return states.size(); }
+    };
+
+    static constexpr std::array<const char *, 4> op_names = {"X", "Xdag", "Z", "Zdag"};
+
+    unsigned L;
+    code_t dim;
+    std::vector<code_t> powers;
+    std::array<LocalOp, 4> ops_;
+    std::vector<Term> terms;
+    bool charge_conserved_, translation_invariant_;
+    it::Args args;
+
+    static unsigned op_index(const string & name);
+    unsigned digit(code_t code, unsigned site) const { return (code / powers[site-1]) % N; }
+    std::pair<code_t, complex> apply(code_t code, const std::vector<std::pair<unsigned, unsigned>> & factors) const;
+    std::vector<std::pair<unsigned, unsigned>> factors_of(const OpString & ops) const;
+    code_t translate(code_t code) const;
+    std::pair<code_t, unsigned> representative(code_t code) const;
+
+    Sector sector(int charge, int momentum) const;
+    void matvec(const Sector & sec, const EDVector & x, EDVector & y) const;
+    std::vector<std::pair<double, EDVector>> sector_lowest(const Sector & sec, unsigned n) const;
+    std::vector<std::pair<double, EDVector>> krylov_lowest(
+            const Sector & sec, unsigned n, const std::vector<EDVector> & locked, unsigned run) const;
+    EDVector expand(const Sector & sec, const EDVector & vec) const;
+};
+
+/************************************************************/
+
+namespace detail {
+
+inline complex dot(const EDVector & a, const EDVector & b) {
+    double re = 0.0, im = 0.0;
+    #pragma omp parallel for reduction(+:re,im)
+    for (std::size_t i = 0; i < a.size(); i++) {
+        auto p = std::conj(a[i]) * b[i];
+        re += p.real();
+        im += p.imag();
+    }
+    return {re, im};
+}
+
+// y -= c x
+inline void subtract(EDVector & y, complex c, const EDVector & x) {
+    #pragma omp parallel for
+    for (std::size_t i = 0; i < y.size(); i++)
+        y[i] -= c * x[i];
+}
+
+inline double normalize(EDVector & x) {
+    double nrm = std::sqrt(dot(x, x).real());
+    if (nrm > 0.0) {
+        #pragma omp parallel for
+        for (std::size_t i = 0; i < x.size(); i++)
+            x[i] /= nrm;
+    }
+    return nrm;
+}
+
+// Eigenvalues (ascending) and eigenvectors (columns) of a small Hermitian
+// matrix, by cyclic Jacobi rotations
+inline std::pair<std::vector<double>, std::vector<EDVector>>
+hermitian_eigen(std::vector<EDVector> A) {
+    auto n = A.size();
+    std::vector<EDVector> V(n, EDVector(n, 0.0));
+    for (std::size_t i = 0; i < n; i++)
+        V[i][i] = 1.0;
+
+    auto off_norm = [&A, n]() {
+        double off = 0.0, all = 0.0;
+        for (std::size_t i = 0; i < n; i++)
+            for (std::size_t j = 0; j < n; j++) {
+                all += std::norm(A[i][j]);
+                if (i != j)
+                    off += std::norm(A[i][j]);
+            }
+        return std::pair<double, double>{off, all};
+    };
+
+    for (int sweep = 0; sweep < 100; sweep++) {
+        auto [off, all] = off_norm();
+        if (off <= 1e-28 * std::max(all, 1e-300))
+            break;
+        for (std::size_t p = 0; p + 1 < n; p++)
+        for (std::size_t q = p + 1; q < n; q++) {
+            double b = std::abs(A[p][q]);
+            if (b < 1e-300)
+                continue;
+            // phase to a real symmetric 2x2 block, then a real rotation
+            complex e = A[p][q] / b;
+            double theta = 0.5 * std::atan2(2.0 * b, A[q][q].real() - A[p][p].real());
+            double c = std::cos(theta), s = std::sin(theta);
+            complex Jpp = c, Jpq = s, Jqp = -s * std::conj(e), Jqq = c * std::conj(e);
+
+            for (std::size_t k = 0; k < n; k++) {
+                auto akp = A[k][p], akq = A[k][q];
+                A[k][p] = akp * Jpp + akq * Jqp;
+                A[k][q] = akp * Jpq + akq * Jqq;
+                auto vkp = V[k][p], vkq = V[k][q];
+                V[k][p] = vkp * Jpp + vkq * Jqp;
+                V[k][q] = vkp * Jpq + vkq * Jqq;
+            }
+            for (std::size_t k = 0; k < n; k++) {
+                auto apk = A[p][k], aqk = A[q][k];
+                A[p][k] = std::conj(Jpp) * apk + std::conj(Jqp) * aqk;
+                A[q][k] = std::conj(Jpq) * apk + std::conj(Jqq) * aqk;
+            }
+        }
+    }
+
+    std::vector<std::size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&A](auto i, auto j){ return A[i][i].real() < A[j][j].real(); });
+    std::vector<double> values{};
+    std::vector<EDVector> vectors{};
+    for (auto i : order) {
+        values.push_back(A[i][i].real());
+        EDVector column(n);
+        for (std::size_t k = 0; k < n; k++)
+            column[k] = V[k][i];
+        vectors.push_back(std::move(column));
+    }
+    return {values, vectors};
+}
+
+}
+
+
+template<unsigned N>
+ExactChain<N>::ExactChain(const SiteCouplings & couplings, const it::Args & args_) :
+    L(couplings.length()), dim(1), powers(couplings.length()), args(args_)
+{
+    if (L < 2)
+        throw std::invalid_argument("Exact diagonalization needs at least two sites");
+    if (couplings.kinet.size() != L || couplings.longit.size() != L)
+        throw std::invalid_argument("Couplings of the chain must have one value per site");
+    for (auto i : it::range(L)) {
+        powers[i] = dim;
+        if (dim > (code_t(1) << 40) / N)
+            throw std::invalid_argument("Chain too long for exact diagonalization");
+        dim *= N;
+    }
+
+    // Local operators from the site type, as <m|O|n> = O(s=n, s'=m)
+    auto site = ClockSite<N>(it::Args("ConserveQNs", false));
+    auto s = site.index();
+    for (auto o : it::range(op_names.size())) {
+        auto Op = site.op(op_names[o]);
+        auto & local = ops_[o];
+        for (auto n : it::range(N)) {
+            unsigned found = 0;
+            for (auto m : it::range(N)) {
+                auto value = it::eltC(Op, s(n+1), it::prime(s)(m+1));
+                if (std::abs(value) < 1e-14)
+                    continue;
+                if (found++ > 0)
+                    throw std::runtime_error("Local operators with more than one element per column");
+                local.to[n] = m;
+                local.value[n] = value;
+            }
+            if (found == 0) {
+                local.to[n] = n;
+                local.value[n] = 0.0;
+            }
+            int shift = ((int(local.to[n]) - int(n)) % int(N) + int(N)) % int(N);
+            if (n == 0)
+                local.shift = shift;
+            else if (shift != local.shift)
+                local.charged = false;
+        }
+    }
+
+    // Same terms of hamiltonianC
+    const unsigned X = 0, Xdag = 1, Z = 2, Zdag = 3;
+    auto add = [this](complex coeff, std::vector<std::pair<unsigned, unsigned>> factors) {
+        if (std::abs(coeff) > 0.0)
+            terms.push_back({coeff, std::move(factors)});
+    };
+    for (unsigned i = 1; i < L; i++) {
+        add(couplings.kinet[i-1],            {{Zdag, i+1}, {Z, i}});
+        add(std::conj(couplings.kinet[i-1]), {{Zdag, i},   {Z, i+1}});
+    }
+    if (couplings.pbc) {
+        add(couplings.kinet[L-1],            {{Zdag, L}, {Z, 1}});
+        add(std::conj(couplings.kinet[L-1]), {{Zdag, 1}, {Z, L}});
+    }
+    for (unsigned i = 1; i <= L; i++) {
+        add(couplings.transv[i-1],            {{X, i}});
+        add(std::conj(couplings.transv[i-1]), {{Xdag, i}});
+        add(couplings.longit[i-1],            {{Z, i}});
+        add(std::conj(couplings.longit[i-1]), {{Zdag, i}});
+    }
+
+    charge_conserved_ = true;
+    for (const auto & term : terms) {
+        int shift = 0;
+        for (auto [o, i] : term.factors) {
+            charge_conserved_ = charge_conserved_ && ops_[o].charged;
+            shift += ops_[o].shift;
+        }
+        charge_conserved_ = charge_conserved_ && shift % int(N) == 0;
+    }
+    auto uniform = [](const std::vector<complex> & values) {
+        return std::all_of(values.begin(), values.end(), [&values](complex v) { return v == values.front(); });
+    };
+    translation_invariant_ = couplings.pbc && couplings.kinet.front().imag() == 0.0
+        && uniform(couplings.kinet) && uniform(couplings.transv) && uniform(couplings.longit);
+}
+
+template<unsigned N>
+unsigned
+ExactChain<N>::op_index(const string & name) {
+    for (auto o : it::range(op_names.size()))
+        if (name == op_names[o])
+            return o;
+    throw std::runtime_error("Unrecognized operator \"" + name + "\"");
+}
+
+template<unsigned N>
+std::pair<typename ExactChain<N>::code_t, complex>
+ExactChain<N>::apply(code_t code, const std::vector<std::pair<unsigned, unsigned>> & factors) const {
+    complex value = 1.0;
+    // the rightmost operator acts first
+    for (auto f = factors.rbegin(); f != factors.rend(); f++) {
+        auto [o, i] = *f;
+        auto n = digit(code, i);
+        value *= ops_[o].value[n];
+        code = code + (code_t(ops_[o].to[n]) - n) * powers[i-1];
+    }
+    return {code, value};
+}
+
+template<unsigned N>
+typename ExactChain<N>::code_t
+ExactChain<N>::translate(code_t code) const {
+    // the state of site i moves to site i+1, the last one to the first
+    return (code % powers[L-1]) * N + code / powers[L-1];
+}
+
+template<unsigned N>
+std::pair<typename ExactChain<N>::code_t, unsigned>
+ExactChain<N>::representative(code_t code) const {
+    // smallest configuration of the orbit, with code = T^shift rep
+    code_t rep = code, current = code;
+    unsigned steps = 0;
+    for (unsigned j = 1; j < L; j++) {
+        current = translate(current);
+        if (current < rep) {
+            rep = current;
+            steps = j;
+        }
+    }
+    return {rep, (L - steps) % L};
+}
+
+template<unsigned N>
+typename ExactChain<N>::Sector
+ExactChain<N>::sector(int charge, int momentum) const {
+    auto sec = Sector{charge, momentum};
+    for (code_t code = 0; code < dim; code++) {
+        if (charge >= 0) {
+            unsigned total = 0;
+            for (auto i : it::range1(L))
+                total += digit(code, i);
+            if (int(total % N) != charge)
+                continue;
+        }
+        if (momentum < 0) {
+            sec.states.push_back(code);
+            continue;
+        }
+        // representatives compatible with the momentum, exp(-i k R) = 1
+        unsigned period = 1;
+        bool is_rep = true;
+        for (auto current = translate(code); current != code; current = translate(current), period++)
+            if (current < code) {
+                is_rep = false;
+                break;
+            }
+        if (is_rep && (momentum * period) % L == 0) {
+            sec.states.push_back(code);
+            sec.periods.push_back(period);
+        }
+    }
+    return sec;
+}
+
+template<unsigned N>
+void
+ExactChain<N>::matvec(const Sector & sec, const EDVector & x, EDVector & y) const {
+    double k = 2.0 * M_PI * sec.momentum / L;
+    auto index_of = [&sec, this](code_t code) -> std::size_t {
+        if (sec.states.size() == dim)
+            return code;
+        auto found = std::lower_bound(sec.states.begin(), sec.states.end(), code);
+        if (found == sec.states.end() || *found != code)
+            return sec.states.size();
+        return found - sec.states.begin();
+    };
+
+    // y[r] = sum_a conj(H_{a r}) x[a], with the column r from H|r>:
+    // each thread writes only its own rows
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (std::size_t r = 0; r < sec.size(); r++) {
+        complex sum = 0.0;
+        for (const auto & term : terms) {
+            auto [code, value] = apply(sec.states[r], term.factors);
+            if (value == 0.0)
+                continue;
+            complex element = term.coeff * value;
+            std::size_t a;
+            if (sec.momentum < 0) {
+                a = index_of(code);
+            } else {
+                // H|r,k> = sum h exp(i k l) sqrt(R_r / R_b) |b,k>, with T^l b the result
+                auto [rep, shift] = representative(code);
+                a = index_of(rep);
+                if (a < sec.size())
+                    element *= std::polar(1.0, k * shift)
+                             * std::sqrt(double(sec.periods[r]) / sec.periods[a]);
+            }
+            if (a < sec.size())
+                sum += std::conj(element) * x[a];
+        }
+        y[r] = sum;
+    }
+}
+
+template<unsigned N>
+std::vector<std::pair<double, EDVector>>
+ExactChain<N>::sector_lowest(const Sector & sec, unsigned n) const {
+    n = std::min<std::size_t>(n, sec.size());
+    double tol = args.getReal("EDTolerance", 1e-10);
+
+    // deflation: each run finds the lowest levels orthogonal to the
+    // previous ones, e.g. the partners of the degenerate levels
+    std::vector<std::pair<double, EDVector>> levels{};
+    std::vector<EDVector> locked{};
+    for (unsigned run = 0; locked.size() < sec.size(); run++) {
+        auto found = krylov_lowest(sec, n, locked, run);
+        if (found.empty())
+            break;
+        if (levels.size() >= n && found.front().first > levels[n-1].first - tol * std::max(1.0, std::abs(levels[n-1].first)))
+            break;
+        for (auto & level : found) {
+            locked.push_back(level.second);
+            levels.push_back(std::move(level));
+        }
+        std::sort(levels.begin(), levels.end(),
+                [](const auto & a, const auto & b){ return a.first < b.first; });
+    }
+    if (levels.size() > n)
+        levels.resize(n);
+    return levels;
+}
+
+template<unsigned N>
+std::vector<std::pair<double, EDVector>>
+ExactChain<N>::krylov_lowest(
+    const Sector & sec,
+    unsigned n,
+    const std::vector<EDVector> & locked,
+    unsigned run
+) const {
+    std::size_t D = sec.size() - locked.size();
+    std::size_t m = std::min<std::size_t>(D, std::max(args.getInt("EDKrylov", 40), int(2 * n + 2)));
+    n = std::min<std::size_t>(n, D);
+    double tol = args.getReal("EDTolerance", 1e-10);
+    int max_restarts = args.getInt("EDMaxRestarts", 500);
+
+    // the Krylov space stays orthogonal to the locked levels
+    auto deflate = [&locked](EDVector & x) {
+        for (int pass = 0; pass < 2; pass++)
+            for (const auto & y : locked)
+                detail::subtract(x, detail::dot(y, x), y);
+    };
+
+    std::mt19937_64 gen(args.getInt("EDSeed", 1) + 7919 * (sec.charge + 1) + 104729 * (sec.momentum + 1) + 15485863 * run);
+    std::normal_distribution<double> normal{};
+    EDVector v(sec.size());
+    for (auto & c : v)
+        c = complex(normal(gen), normal(gen));
+    deflate(v);
+    if (detail::normalize(v) == 0.0)
+        return {};
+
+    std::vector<EDVector> V{};
+    std::vector<EDVector> T(m, EDVector(m, 0.0));
+    EDVector w(sec.size());
+    std::vector<double> theta{};
+    std::vector<EDVector> Y{};
+
+    for (int restart = 0; restart <= max_restarts; restart++) {
+        // extend the basis up to m vectors, with the projections of H
+        // on all the previous ones (arrowhead after a restart)
+        double beta = 0.0;
+        bool exhausted = false;
+        while (V.size() < m) {
+            auto j = V.size();
+            V.push_back(v);
+            matvec(sec, V[j], w);
+            for (std::size_t i = 0; i <= j; i++)
+                T[i][j] = 0.0;
+            for (int pass = 0; pass < 2; pass++)
+                for (std::size_t i = 0; i <= j; i++) {
+                    auto h = detail::dot(V[i], w);
+                    T[i][j] += h;
+                    detail::subtract(w, h, V[i]);
+                }
+            deflate(w);
+            for (std::size_t i = 0; i < j; i++)
+                T[j][i] = std::conj(T[i][j]);
+            T[j][j] = T[j][j].real();
+
+            beta = detail::normalize(w);
+            v = w;
+            if (beta < 1e-12 * std::max(1.0, std::abs(T[j][j]))) {
+                exhausted = true;
+                break;
+            }
+        }
+
+        auto j = V.size();
+        std::vector<EDVector> Tj(j, EDVector(j));
+        for (std::size_t a = 0; a < j; a++)
+            for (std::size_t b = 0; b < j; b++)
+                Tj[a][b] = T[a][b];
+        std::tie(theta, Y) = detail::hermitian_eigen(Tj);
+
+        bool converged = exhausted || j == D;
+        if (!converged) {
+            converged = true;
+            for (std::size_t i = 0; i < n; i++)
+                converged = converged && beta * std::abs(Y[i][j-1]) < tol * std::max(1.0, std::abs(theta[i]));
+        }
+
+        // Ritz vectors: the lowest n if converged, else the ones kept
+        // for the restart
+        std::size_t keep = converged ? std::min<std::size_t>(n, j) : std::min(j - 1, std::max<std::size_t>(n, m / 2));
+        std::vector<EDVector> ritz(keep, EDVector(sec.size(), 0.0));
+        #pragma omp parallel for
+        for (std::size_t x = 0; x < sec.size(); x++)
+            for (std::size_t i = 0; i < keep; i++)
+                for (std::size_t l = 0; l < j; l++)
+                    ritz[i][x] += V[l][x] * Y[i][l];
+
+        if (converged || restart == max_restarts) {
+            std::vector<std::pair<double, EDVector>> levels{};
+            for (std::size_t i = 0; i < keep; i++)
+                levels.emplace_back(theta[i], std::move(ritz[i]));
+            return levels;
+        }
+
+        // thick restart: the kept Ritz vectors, then the residual
+        V = std::move(ritz);
+        for (std::size_t a = 0; a < m; a++)
+            for (std::size_t b = 0; b < m; b++)
+                T[a][b] = (a == b && a < keep) ? complex(theta[a]) : complex(0.0);
+    }
+    return {};
+}
+
+template<unsigned N>
+EDVector
+ExactChain<N>::expand(const Sector & sec, const EDVector & vec) const {
+    if (sec.momentum < 0 && sec.size() == dim)
+        return vec;
+
+    EDVector full(dim, 0.0);
+    double k = 2.0 * M_PI * sec.momentum / L;
+    for (std::size_t r = 0; r < sec.size(); r++) {
+        if (sec.momentum < 0) {
+            full[sec.states[r]] = vec[r];
+            continue;
+        }
+        // |r,k> = sqrt(R / L^2) sum_j exp(-i k j) T^j |r>
+        double weight = std::sqrt(double(sec.periods[r])) / L;
+        auto code = sec.states[r];
+        for (unsigned j = 0; j < L; j++, code = translate(code))
+            full[code] += vec[r] * weight * std::polar(1.0, -k * j);
+    }
+    return full;
+}
+
+template<unsigned N>
+double
+ExactChain<N>::memory_mb(unsigned length, unsigned n, const it::Args & args) {
+    double dim = std::pow(double(N), double(length));
+    double m = std::max(args.getInt("EDKrylov", 40), int(2 * n + 2));
+    return dim * (sizeof(complex) * (1.5 * m + 3 * n + 2) + sizeof(code_t)) / 1048576.0;
+}
+
+template<unsigned N>
+std::vector<EDLevel>
+ExactChain<N>::lowest(unsigned n) const {
+    auto needed = memory_mb(L, n, args);
+    if (needed > args.getReal("EDMaxMemory", 4096.))
+        throw std::invalid_argument(
+                "Exact diagonalization needs about " + std::to_string(int(needed))
+              + " MB, more than \"EDMaxMemory\"");
+    std::vector<int> charges{-1}, momenta{-1};
+    if (charge_conserved_) {
+        charges.clear();
+        for (auto q : it::range(N))
+            charges.push_back(q);
+    }
+    if (translation_invariant_) {
+        momenta.clear();
+        for (auto k : it::range(L))
+            momenta.push_back(k);
+    }
+
+    std::vector<EDLevel> levels{};
+    for (auto q : charges)
+        for (auto k : momenta) {
+            auto sec = sector(q, k);
+            if (sec.size() == 0)
+                continue;
+            for (auto & [energy, vec] : sector_lowest(sec, n))
+                levels.emplace_back(energy, expand(sec, vec));
+        }
+
+    std::sort(levels.begin(), levels.end(),
+            [](const auto & a, const auto & b){ return a.first < b.first; });
+    if (levels.size() > n)
+        levels.resize(n);
+    return levels;
+}
+
+template<unsigned N>
+std::vector<std::pair<unsigned, unsigned>>
+ExactChain<N>::factors_of(const OpString & ops) const {
+    std::vector<std::pair<unsigned, unsigned>> factors{};
+    for (const auto & [name, site] : ops) {
+        if (site < 1 || site > L)
+            throw std::runtime_error("Operator site out of the chain");
+        factors.emplace_back(op_index(name), site);
+    }
+    return factors;
+}
+
+template<unsigned N>
+complex
+ExactChain<N>::expectation(const EDVector & bra, const OpString & ops, const EDVector & ket) const {
+    auto factors = factors_of(ops);
+    double re = 0.0, im = 0.0;
+    #pragma omp parallel for reduction(+:re,im)
+    for (code_t a = 0; a < dim; a++) {
+        if (ket[a] == 0.0)
+            continue;
+        auto [b, value] = apply(a, factors);
+        auto p = std::conj(bra[b]) * value * ket[a];
+        re += p.real();
+        im += p.imag();
+    }
+    return {re, im};
+}
+
+template<unsigned N>
+EDVector
+ExactChain<N>::product(const OpString & ops, const EDVector & ket) const {
+    auto factors = factors_of(ops);
+    // a product of the local operators is again a permutation with
+    // weights, so that every configuration is reached at most once
+    EDVector result(dim, 0.0);
+    #pragma omp parallel for
+    for (code_t a = 0; a < dim; a++) {
+        if (ket[a] == 0.0)
+            continue;
+        auto [b, value] = apply(a, factors);
+        if (value != 0.0)
+            result[b] = value * ket[a];
+    }
+    return result;
+}
+
+template<unsigned N>
+EDVector
+ExactChain<N>::correction_vector(const EDVector & gs, double energy, const EDVector & perturbed) const {
+    auto full = sector(-1, -1);
+    double tol = args.getReal("ResponseTolerance", 1e-10);
+    int max_iter = args.getInt("ResponseMaxIter", 1000);
+    auto project = [&gs](EDVector & v) { detail::subtract(v, detail::dot(gs, v), gs); };
+
+    // right hand side - (1 - P0) V|gs>
+    auto rhs = perturbed;
+    project(rhs);
+    for (auto & c : rhs)
+        c = -c;
+    double rhs_norm = std::sqrt(detail::dot(rhs, rhs).real());
+
+    // conjugate gradient, (H - E0) is positive in the complement of gs
+    EDVector x(dim, 0.0), r = rhs, p = rhs, Ap(dim);
+    double rr = rhs_norm * rhs_norm;
+    for (int iter = 0; iter < max_iter && std::sqrt(rr) > tol * rhs_norm; iter++) {
+        matvec(full, p, Ap);
+        detail::subtract(Ap, energy, p);
+        project(Ap);
+        double pAp = detail::dot(p, Ap).real();
+        if (pAp <= 0.0)
+            break;
+        detail::subtract(x, -rr / pAp, p);
+        detail::subtract(r, rr / pAp, Ap);
+        double rr_new = detail::dot(r, r).real();
+        #pragma omp parallel for
+        for (std::size_t i = 0; i < p.size(); i++)
+            p[i] = r[i] + (rr_new / rr) * p[i];
+        rr = rr_new;
+    }
+    project(x);
+    return x;
+}
+
+template<unsigned N>
+it::MPS
+ExactChain<N>::to_mps(const EDVector & state, const Clock<N> & sites) const {
+    std::vector<it::Index> inds{};
+    for (auto i : it::range1(L))
+        inds.push_back(sites(i));
+    auto T = it::ITensor(it::IndexSet(inds));
+    std::vector<it::IndexVal> ivs(L);
+    for (code_t code = 0; code < dim; code++) {
+        for (auto i : it::range1(L))
+            ivs[i-1] = sites(i)(digit(code, i) + 1);
+        T.set(ivs, state[code]);
+    }
+
+    // successive SVDs from the left
+    std::vector<it::ITensor> M(L + 1);
+    it::Index link;
+    for (auto b : it::range1(L - 1)) {
+        auto left = link ? it::IndexSet(link, sites(b)) : it::IndexSet(sites(b));
+        auto [U, S, V] = it::svd(T, left, {"Cutoff", 1e-14});
+        link = it::commonIndex(U, S);
+        M[b] = U;
+        T = S * V;
+    }
+    M[L] = T;
+    return detail::Environments::to_mps(it::MPS(sites), M);
+}
+
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef __CLOCK_ENVIRONMENTS_H
+#define __CLOCK_ENVIRONMENTS_H
+
+#include <vector>
+
+#include "itensor/all.h"
+#include "types.h"
+
+/************************************************************/
+namespace clocks::detail {
+
+///
+/// Site tensors of an MPS and of an MPO, with the environments used by
+/// the sweeps of the custom DMRG solvers. Everything is stored per site,
+/// so that disjoint ranges of sites can be updated concurrently
+///
+struct Environments {
+    unsigned length;
+    std::vector<it::ITensor> W;     // MPO tensors, 1..L
+    std::vector<it::ITensor> M;     // MPS tensors, 1..L
+    std::vector<it::ITensor> LE;    // LE[j]: left environment of sites 1..j
+    std::vector<it::ITensor> RE;    // RE[j]: right environment of sites j..L
+
+    /// Start from psi0 orthogonalized on the first site,
+    /// with all the right environments
+    Environments(const it::MPO & H, const it::MPS & psi0);
+
+    /// Left environment of sites 1..j, with A on the j-th site
+    it::ITensor extend_left(unsigned j, const it::ITensor & A) const;
+
+    /// Right environment of sites j..L, with B on the j-th site
+    it::ITensor extend_right(unsigned j, const it::ITensor & B) const;
+
+    /// Normalized MPS made of the given site tensors (1..L)
+    static it::MPS to_mps(it::MPS psi, const std::vector<it::ITensor> & tensors);
+};
+
+/************************************************************/
+
+inline
+Environments::Environments(const it::MPO & H, const it::MPS & psi0) :
+    length(it::length(psi0)),
+    W(length + 2), M(length + 2), LE(length + 2), RE(length + 2)
+{
+    auto psi = psi0;
+    psi.position(1);
+    for (auto j : it::range1(length)) {
+        W[j] = H(j);
+        M[j] = psi(j);
+    }
+    for (auto j = length; j >= 2; j--)
+        RE[j] = extend_right(j, M[j]);
+}
+
+inline it::ITensor
+Environments::extend_left(unsigned j, const it::ITensor & A) const {
+    auto E = LE[j-1] ? LE[j-1] * A : A;
+    return E * W[j] * it::dag(it::prime(A));
+}
+
+inline it::ITensor
+Environments::extend_right(unsigned j, const it::ITensor & B) const {
+    auto E = RE[j+1] ? RE[j+1] * B : B;
+    return E * W[j] * it::dag(it::prime(B));
+}
+
+inline it::MPS
+Environments::to_mps(it::MPS psi, const std::vector<it::ITensor> & tensors) {
+    for (auto j : it::range1(it::length(psi)))
+        psi.set(j, tensors.at(j));
+    psi.position(1);
+    psi.ref(1) /= it::norm(psi(1));
+    return psi;
+}
+
+}
+
+#endif
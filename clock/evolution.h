@@ -0,0 +1,308 @@
+#ifndef __CLOCK_EVOLUTION_H
+#define __CLOCK_EVOLUTION_H
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <stdexcept>
+
+#include "itensor/all.h"
+#include "clock.h"
+#include "types.h"
+#include "hamiltonian.h"
+#include "environments.h"
+
+/************************************************************/
+namespace clocks {
+
+///
+/// Second order Trotter gates of the open chain with the given couplings,
+/// exp(-i dt/2 h_b) for the bonds b = 1..L-1, or exp(-dt/2 h_b) in
+/// imaginary time (it::BondGate::tImag), where h_b is the kinetic term of
+/// the bond plus the fields of its two sites, halved on the sites shared
+/// with the neighbouring bonds. A step of dt applies the gates to the
+/// right and then back to the left
+///
+template<unsigned N>
+class TrotterGates {
+    std::vector<it::BondGate> gates;
+
+public:
+    TrotterGates(
+        const Clock<N> & sites,
+        const ChainCouplings & couplings,
+        double dt,
+        it::BondGate::Type type = it::BondGate::tReal
+    );
+
+    /// One step of dt on psi, truncated with "MaxDim" and "Cutoff"
+    void apply(it::MPS & psi, const it::Args & args) const;
+};
+
+///
+/// Trotter gates of a site set, built once for each couplings and dt and
+/// then shared by all the steps and runs, also from concurrent threads.
+/// A copy starts with an empty cache
+///
+template<unsigned N>
+class GateCache {
+    Clock<N> sites_;
+    mutable std::mutex mtx;
+    mutable std::map<string, std::shared_ptr<const TrotterGates<N>>> entries{};
+
+public:
+    explicit GateCache(const Clock<N> & sites) : sites_(sites) {}
+    GateCache(const GateCache & other) : sites_(other.sites_) {}
+
+    const Clock<N> & sites() const { return sites_; }
+
+    /// Gates of the given couplings and dt, built on the first request
+    std::shared_ptr<const TrotterGates<N>> get(
+        const ChainCouplings & couplings,
+        double dt,
+        it::BondGate::Type type = it::BondGate::tReal
+    ) const;
+
+    std::size_t size() const;
+};
+
+/// Real-time evolution exp(-i H t) psi under the chain Hamiltonian with
+/// the given couplings, for n_steps steps of dt.
+/// measure(step, time, psi) is called on the initial state, every
+/// "MeasureEvery" steps (1) and on the final state.
+/// "Method" is "TEBD" (default), with the gates of the cache, or "TDVP",
+/// which is always used with PBC, where the bond (L, 1) is not a
+/// nearest-neighbour gate. "MaxDim" and "Cutoff" truncate the states.
+/// Returns the final state
+template<unsigned N, typename Measure>
+it::MPS evolve(
+    const GateCache<N> & cache,
+    const ChainCouplings & couplings,
+    it::MPS psi,
+    double dt,
+    unsigned n_steps,
+    Measure && measure,
+    const it::Args & args = {}
+);
+
+/// Real-time evolution by two-site TDVP (Haegeman et al. 2016) under any
+/// MPO, e.g. with PBC or long-range terms, as evolve with "Method" "TDVP".
+/// "MaxIter" and "ErrGoal" are passed to the Krylov exponential
+template<typename Measure>
+it::MPS evolve_tdvp(
+    const it::MPO & H,
+    it::MPS psi,
+    double dt,
+    unsigned n_steps,
+    Measure && measure,
+    const it::Args & args = {}
+);
+
+/************************************************************/
+
+namespace detail {
+
+// Identity on the i-th site
+template<unsigned N>
+it::ITensor site_identity(const Clock<N> & sites, int i) {
+    auto s = sites(i);
+    auto sP = it::prime(s);
+    auto Id = it::ITensor(it::dag(s), sP);
+    for (auto n : it::range1(N))
+        Id.set(s(n), sP(n), 1.0);
+    return Id;
+}
+
+// step() n_steps times, with measure(step, time) on the initial state,
+// every `every` steps and on the final state
+template<typename Step, typename Measure>
+void time_steps(unsigned n_steps, double dt, unsigned every, Step && step, Measure && measure) {
+    if (every == 0)
+        throw std::invalid_argument("\"MeasureEvery\" must be positive");
+    measure(0u, 0.0);
+    for (auto n = 1u; n <= n_steps; n++) {
+        step();
+        if (n % every == 0 || n == n_steps)
+            measure(n, n * dt);
+    }
+}
+
+///
+/// Two-site TDVP sweeps over the site tensors and environments: each
+/// bond is evolved forward and the site left behind backward, so that
+/// a sweep to the right and back is a symmetric second order step
+///
+class TDVP : public Environments {
+public:
+    TDVP(const it::MPO & H, const it::MPS & psi0) : Environments(H, psi0) {}
+
+    /// One step of dt, a sweep to the right and back of dt/2 each,
+    /// exp(-i dt H) also for complex dt, e.g. dt = -i tau in imaginary
+    /// time, with the state normalized at the end
+    void step(complex dt, const it::Args & args);
+};
+
+inline void
+TDVP::step(complex dt, const it::Args & args) {
+    auto forward  = complex(0.0, -0.5) * dt;
+    auto backward = -forward;
+
+    for (auto b = 1u; b < length; b++) {
+        auto phi = M[b] * M[b+1];
+        auto bond_op = it::LocalOp(W[b], W[b+1], LE[b-1], RE[b+2]);
+        it::applyExp(bond_op, phi, forward, args);
+        auto [U, S, Vt] = it::svd(phi, it::uniqueInds(M[b], M[b+1]), args);
+        M[b]   = U;
+        M[b+1] = S * Vt;
+        LE[b]  = extend_left(b, U);
+        if (b + 1 < length) {
+            auto site_op = it::LocalOp(W[b+1], LE[b], RE[b+2]);
+            it::applyExp(site_op, M[b+1], backward, args);
+        }
+    }
+    for (auto b = length - 1; b >= 1; b--) {
+        auto phi = M[b] * M[b+1];
+        auto bond_op = it::LocalOp(W[b], W[b+1], LE[b-1], RE[b+2]);
+        it::applyExp(bond_op, phi, forward, args);
+        auto [U, S, Vt] = it::svd(phi, it::uniqueInds(M[b], M[b+1]), args);
+        M[b]    = U * S;
+        M[b+1]  = Vt;
+        RE[b+1] = extend_right(b+1, Vt);
+        if (b > 1) {
+            auto site_op = it::LocalOp(W[b], LE[b-1], RE[b+1]);
+            it::applyExp(site_op, M[b], backward, args);
+        }
+    }
+    M[1] /= it::norm(M[1]);
+}
+
+}
+
+
+template<unsigned N>
+TrotterGates<N>::TrotterGates(
+    const Clock<N> & sites,
+    const ChainCouplings & couplings,
+    double dt,
+    it::BondGate::Type type
+) {
+    int L = it::length(sites);
+    if (L < 2)
+        throw std::invalid_argument("Trotter gates need at least two sites");
+
+    auto kin = couplings.kinet, transv = couplings.transv, longit = couplings.longit;
+    auto field = [&](int i) {
+        return transv * it::op(sites, "X", i) + std::conj(transv) * it::op(sites, "Xdag", i)
+             + longit * it::op(sites, "Z", i) + std::conj(longit) * it::op(sites, "Zdag", i);
+    };
+    // share of the field of a site in each of its bonds
+    auto weight = [L](int i) { return (i == 1 || i == L) ? 1.0 : 0.5; };
+
+    gates.reserve(L - 1);
+    for (auto b : it::range1(L - 1)) {
+        auto h = kin * it::op(sites, "Zdag", b+1) * it::op(sites, "Z", b)
+               + std::conj(kin) * it::op(sites, "Zdag", b) * it::op(sites, "Z", b+1)
+               + weight(b)   * field(b) * detail::site_identity(sites, b+1)
+               + weight(b+1) * detail::site_identity(sites, b) * field(b+1);
+        gates.emplace_back(sites, b, b+1, type, 0.5 * dt, h);
+    }
+}
+
+template<unsigned N>
+void
+TrotterGates<N>::apply(it::MPS & psi, const it::Args & args) const {
+    auto apply_gate = [&psi, &args](const it::BondGate & gate, it::Direction dir) {
+        auto b = gate.i1();
+        psi.position(b);
+        auto AA = psi(b) * psi(b+1) * gate.gate();
+        AA.noPrime();
+        psi.svdBond(b, AA, dir, args);
+    };
+    for (auto g = gates.begin(); g != gates.end(); g++)
+        apply_gate(*g, it::Fromleft);
+    for (auto g = gates.rbegin(); g != gates.rend(); g++)
+        apply_gate(*g, it::Fromright);
+    psi.normalize();
+}
+
+
+template<unsigned N>
+std::shared_ptr<const TrotterGates<N>>
+GateCache<N>::get(
+    const ChainCouplings & couplings,
+    double dt,
+    it::BondGate::Type type
+) const {
+    auto key = utils::exact_str(couplings.kinet.real())  + " " + utils::exact_str(couplings.kinet.imag())  + " "
+             + utils::exact_str(couplings.transv.real()) + " " + utils::exact_str(couplings.transv.imag()) + " "
+             + utils::exact_str(couplings.longit.real()) + " " + utils::exact_str(couplings.longit.imag()) + " "
+             + utils::exact_str(dt) + (type == it::BondGate::tImag ? " imaginary" : "");
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (auto entry = entries.find(key); entry != entries.end())
+            return entry->second;
+    }
+    // built outside of the lock, a concurrent duplicate is simply dropped
+    auto gates = std::make_shared<const TrotterGates<N>>(sites_, couplings, dt, type);
+    std::lock_guard<std::mutex> lock(mtx);
+    return entries.emplace(key, gates).first->second;
+}
+
+template<unsigned N>
+std::size_t
+GateCache<N>::size() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return entries.size();
+}
+
+
+template<unsigned N, typename Measure>
+it::MPS evolve(
+    const GateCache<N> & cache,
+    const ChainCouplings & couplings,
+    it::MPS psi,
+    double dt,
+    unsigned n_steps,
+    Measure && measure,
+    const it::Args & args
+) {
+    auto method = args.getString("Method", "TEBD");
+    if (method != "TEBD" && method != "TDVP")
+        throw std::invalid_argument("Unknown evolution method \"" + method + "\"");
+    if (method == "TDVP" || couplings.pbc)
+        return evolve_tdvp(hamiltonianC<N>(cache.sites(), couplings), std::move(psi), dt, n_steps, measure, args);
+
+    auto gates = cache.get(couplings, dt);
+    detail::time_steps(
+            n_steps, dt, args.getInt("MeasureEvery", 1),
+            [&]() { gates->apply(psi, args); },
+            [&](unsigned n, double t) { measure(n, t, psi); }
+        );
+    return psi;
+}
+
+template<typename Measure>
+it::MPS evolve_tdvp(
+    const it::MPO & H,
+    it::MPS psi,
+    double dt,
+    unsigned n_steps,
+    Measure && measure,
+    const it::Args & args
+) {
+    auto solver = detail::TDVP(H, psi);
+    detail::time_steps(
+            n_steps, dt, args.getInt("MeasureEvery", 1),
+            [&]() { solver.step(dt, args); },
+            [&](unsigned n, double t) {
+                psi = detail::Environments::to_mps(psi, solver.M);
+                measure(n, t, psi);
+            }
+        );
+    return psi;
+}
+
+}
+
+#endif
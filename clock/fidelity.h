@@ -0,0 +1,113 @@
+#ifndef __CLOCK_FIDELITY_H
+#define __CLOCK_FIDELITY_H
+
+#include <cmath>
+#include <mutex>
+#include <vector>
+#include <optional>
+#include <utility>
+#include <stdexcept>
+
+#include "itensor/all.h"
+#include "types.h"
+
+/************************************************************/
+namespace clocks {
+
+/// Fidelity between two states, |<psi1|psi2>|
+/// the states must live on the same sites
+inline double fidelity(const it::MPS & psi1, const it::MPS & psi2);
+
+/// Fidelity susceptibility per site from the fidelity between
+/// the ground states at couplings g and g + delta
+///     chi_F = -2 log(F) / (L delta^2)
+inline double fidelity_susceptibility(double fid, double delta, unsigned length);
+
+/************************************************************/
+
+inline double fidelity(const it::MPS & psi1, const it::MPS & psi2) {
+    return std::abs(it::innerC(psi1, psi2));
+}
+
+inline double fidelity_susceptibility(double fid, double delta, unsigned length) {
+    if (delta == 0.0)
+        throw std::invalid_argument("Vanishing coupling step for the fidelity susceptibility");
+    return -2.0 * std::log(fid) / (double(length) * delta * delta);
+}
+
+///
+/// Keeps the ground states of a scan only until the overlaps with both
+/// neighbouring points have been computed.
+/// Each pair (i, i+1) is evaluated exactly once, by the thread that
+/// pushes the second state of the pair, so the overlaps are computed
+/// in parallel while at most the states at the borders of the chunks
+/// in progress are held in memory.
+///
+class AdjacentStates {
+    std::vector<std::optional<it::MPS>> states;
+    std::vector<bool> arrived;
+    std::vector<bool> paired;   // paired[i] refers to the pair (i, i+1)
+    std::mutex mtx;
+
+public:
+    // Fidelity of the pair (i, i+1), labelled by i
+    using Overlap = std::pair<unsigned, double>;
+
+    AdjacentStates(unsigned n_points) :
+        states(n_points), arrived(n_points, false),
+        paired(n_points > 0 ? n_points-1 : 0, false) {};
+
+    /// Store the state of the i-th point and return the overlaps that
+    /// became available. An empty state marks the point as done without
+    /// any overlap (e.g. restored from a previous run)
+    std::vector<Overlap> push(unsigned i, std::optional<it::MPS> psi);
+
+private:
+    void release_if_paired(unsigned i);
+};
+
+
+inline std::vector<AdjacentStates::Overlap>
+AdjacentStates::push(unsigned i, std::optional<it::MPS> psi) {
+    // Neighbours ready to be paired, as (pair label, neighbour state)
+    std::vector<std::pair<unsigned, std::optional<it::MPS>>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        states.at(i) = psi;
+        arrived.at(i) = true;
+        if (i > 0 && arrived[i-1])
+            ready.emplace_back(i-1, states[i-1]);
+        if (i+1 < arrived.size() && arrived[i+1])
+            ready.emplace_back(i, states[i+1]);
+    }
+
+    // MPS copies share their storage, the overlaps run outside the lock
+    std::vector<Overlap> overlaps;
+    for (const auto & [label, other] : ready)
+        if (psi && other)
+            overlaps.emplace_back(label, fidelity(psi.value(), other.value()));
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (const auto & item : ready)
+            paired[item.first] = true;
+        release_if_paired(i);
+        if (i > 0)
+            release_if_paired(i-1);
+        if (i+1 < states.size())
+            release_if_paired(i+1);
+    }
+    return overlaps;
+}
+
+inline void
+AdjacentStates::release_if_paired(unsigned i) {
+    bool left_done  = (i == 0) || paired[i-1];
+    bool right_done = (i+1 == states.size()) || paired[i];
+    if (left_done && right_done)
+        states[i].reset();
+}
+
+}
+
+#endif
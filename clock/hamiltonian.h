@@ -1,12 +1,46 @@
 #ifndef __CLOCK_HAMILTONIAN_H
 #define __CLOCK_HAMILTONIAN_H
 
+#include <vector>
+#include <stdexcept>
+
 #include "itensor/all.h"
 #include "clock.h"
 
 /************************************************************/
 namespace clocks {
 
+/// Couplings of the chain, with the terms of hamiltonianC
+///     sum_i kinet Zdag_{i+1} Z_i + transv X_i + longit Z_i + h.c.
+struct ChainCouplings {
+    complex kinet  = -1.0;
+    complex transv =  0.0;
+    complex longit =  0.0;
+    bool pbc = false;
+};
+
+/// Site-dependent couplings of the chain, with the terms
+///     sum_i kinet_i Zdag_{i+1} Z_i + transv_i X_i + longit_i Z_i + h.c.
+/// one per site i = 1..L (index i-1 of the vectors), where kinet_L couples
+/// the sites L and 1 with PBC and is unused otherwise
+struct SiteCouplings {
+    std::vector<complex> kinet{};
+    std::vector<complex> transv{};
+    std::vector<complex> longit{};
+    bool pbc = false;
+
+    SiteCouplings() = default;
+
+    /// The same couplings on every site
+    SiteCouplings(unsigned length, const ChainCouplings & uniform) :
+        kinet(length, uniform.kinet),
+        transv(length, uniform.transv),
+        longit(length, uniform.longit),
+        pbc(uniform.pbc) {}
+
+    unsigned length() const { return transv.size(); }
+};
+
 // Non-chiral Hamiltonians (aka only real couplings).
 // pass parameters explicitly
 template<unsigned int N>
@@ -18,6 +52,17 @@ it::MPO hamiltonian(
     bool pbc    = false
 );
 
+/// Non-chiral Hamiltonians (aka only real couplings).
+/// site-dependent couplings, one per site as in SiteCouplings
+template<unsigned int N>
+it::MPO hamiltonian(
+    const clocks::Clock<N> & sites,
+    const std::vector<double> & kinet,
+    const std::vector<double> & transv,
+    const std::vector<double> & longit,
+    bool pbc = false
+);
+
 /// Non-chiral Hamiltonians (aka only real couplings).
 /// pass Args object for parameters
 template<unsigned int N>
@@ -45,6 +90,28 @@ it::MPO hamiltonianC(
     const it::Args & args = it::Args::global()
 );
 
+/// Chiral Hamiltonians, with the couplings of a ChainCouplings
+template<unsigned int N>
+it::MPO hamiltonianC(
+    const clocks::Clock<N> & sites,
+    const ChainCouplings & couplings
+);
+
+/// Chiral Hamiltonians with site-dependent couplings
+template<unsigned int N>
+it::MPO hamiltonianC(
+    const clocks::Clock<N> & sites,
+    const SiteCouplings & couplings
+);
+
+/// Longitudinal term alone, sum_i longit Z_i + conj(longit) Zdag_i
+/// e.g. derivative of hamiltonianC with respect to the longitudinal coupling
+template<unsigned int N>
+it::MPO longitudinal_term(
+    const clocks::Clock<N> & sites,
+    complex longit
+);
+
 /************************************************************/
 
 
@@ -58,33 +125,54 @@ it::MPO hamiltonian(
     double transv,
     double longit,
     bool pbc
+) {
+    auto L = length(sites);
+    return hamiltonian(
+        sites,
+        std::vector<double>(L, kin),
+        std::vector<double>(L, transv),
+        std::vector<double>(L, longit),
+        pbc
+    );
+}
+
+
+template<unsigned int N>
+it::MPO hamiltonian(
+    const clocks::Clock<N> & sites,
+    const std::vector<double> & kin,
+    const std::vector<double> & transv,
+    const std::vector<double> & longit,
+    bool pbc
 ) {
     int L = length(sites);
+    if (int(kin.size()) != L || int(transv.size()) != L || int(longit.size()) != L)
+        throw std::invalid_argument("Couplings of the Hamiltonian must have one value per site");
     auto H_ampo = it::AutoMPO(sites);
 
     // Kinetic term
     for (int i=1; i < L; i++) {
-        H_ampo += kin, "Zdag", i+1, "Z",    i;
-        H_ampo += kin, "Zdag", i,   "Z", i+1;
+        H_ampo += kin[i-1], "Zdag", i+1, "Z",    i;
+        H_ampo += kin[i-1], "Zdag", i,   "Z", i+1;
     }
     // naive approach to PBC for the kinetic term
     if (pbc) {
-        H_ampo += kin, "Zdag", L, "Z", 1;
-        H_ampo += kin, "Zdag", 1, "Z", L;
+        H_ampo += kin[L-1], "Zdag", L, "Z", 1;
+        H_ampo += kin[L-1], "Zdag", 1, "Z", L;
     }
 
     // Transversal field
-    if (transv != 0.0)
-        for (int i=1; i <= L; i++) {
-            H_ampo += transv, "X",    i;
-            H_ampo += transv, "Xdag", i;
+    for (int i=1; i <= L; i++)
+        if (transv[i-1] != 0.0) {
+            H_ampo += transv[i-1], "X",    i;
+            H_ampo += transv[i-1], "Xdag", i;
         }
 
     // Longitudinal field
-    if (longit != 0.0)
-        for (int i=1; i<=L; i++) {
-            H_ampo += longit, "Z", i;
-            H_ampo += longit, "Zdag", i;
+    for (int i=1; i<=L; i++)
+        if (longit[i-1] != 0.0) {
+            H_ampo += longit[i-1], "Z", i;
+            H_ampo += longit[i-1], "Zdag", i;
         }
 
     return toMPO(H_ampo);
@@ -115,33 +203,47 @@ it::MPO hamiltonianC(
     complex transv,
     complex longit,
     bool pbc
+) {
+    return hamiltonianC(
+        sites, SiteCouplings(it::length(sites), {kin, transv, longit, pbc})
+    );
+}
+
+
+template<unsigned int N>
+it::MPO hamiltonianC(
+    const clocks::Clock<N> & sites,
+    const SiteCouplings & couplings
 ) {
     int L = it::length(sites);
+    const auto & [kin, transv, longit, pbc] = couplings;
+    if (int(kin.size()) != L || int(transv.size()) != L || int(longit.size()) != L)
+        throw std::invalid_argument("Couplings of the Hamiltonian must have one value per site");
     auto H_ampo = it::AutoMPO(sites);
 
     // Kinetic term
     for (int i=1; i < L; i++) {
-        H_ampo += kin,       "Zdag", i+1, "Z", i;
-        H_ampo += conj(kin), "Zdag", i,   "Z", i+1;
+        H_ampo += kin[i-1],       "Zdag", i+1, "Z", i;
+        H_ampo += conj(kin[i-1]), "Zdag", i,   "Z", i+1;
     }
     // naive approach to PBC for the kinetic term
     if (pbc) {
-        H_ampo += kin,       "Zdag", L, "Z", 1;
-        H_ampo += conj(kin), "Zdag", 1, "Z", L;
+        H_ampo += kin[L-1],       "Zdag", L, "Z", 1;
+        H_ampo += conj(kin[L-1]), "Zdag", 1, "Z", L;
     }
 
     // Transversal field
-    if (transv != complex(0.0))
-        for (int i=1; i<=L; i++) {
-            H_ampo += transv,       "X",    i;
-            H_ampo += conj(transv), "Xdag", i;
+    for (int i=1; i<=L; i++)
+        if (transv[i-1] != complex(0.0)) {
+            H_ampo += transv[i-1],       "X",    i;
+            H_ampo += conj(transv[i-1]), "Xdag", i;
         }
 
     // Longitudinal field
-    if (longit != complex(0.0))
-        for (int i=1; i<=L; i++) {
-            H_ampo += longit,       "Z",    i;
-            H_ampo += conj(longit), "Zdag", i;
+    for (int i=1; i<=L; i++)
+        if (longit[i-1] != complex(0.0)) {
+            H_ampo += longit[i-1],       "Z",    i;
+            H_ampo += conj(longit[i-1]), "Zdag", i;
         }
 
     return toMPO(H_ampo);
@@ -170,6 +272,32 @@ it::MPO hamiltonianC(
     );
 }
 
+
+template<unsigned int N>
+it::MPO hamiltonianC(
+    const clocks::Clock<N> & sites,
+    const ChainCouplings & couplings
+) {
+    return hamiltonianC(
+        sites, couplings.kinet, couplings.transv, couplings.longit, couplings.pbc
+    );
+}
+
+
+template<unsigned int N>
+it::MPO longitudinal_term(
+    const clocks::Clock<N> & sites,
+    complex longit
+) {
+    int L = it::length(sites);
+    auto ampo = it::AutoMPO(sites);
+    for (int i=1; i<=L; i++) {
+        ampo += longit,       "Z",    i;
+        ampo += conj(longit), "Zdag", i;
+    }
+    return toMPO(ampo);
+}
+
 }
 
 #endif
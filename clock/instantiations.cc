@@ -0,0 +1,7 @@
+// Explicit instantiations of the clock templates, see instantiations.h
+#define CLOCK_INSTANTIATING
+#include "all.h"
+
+namespace clocks {
+    CLOCK_ALL_TEMPLATES()
+}
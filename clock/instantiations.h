@@ -0,0 +1,74 @@
+#ifndef __CLOCK_INSTANTIATIONS_H
+#define __CLOCK_INSTANTIATIONS_H
+
+#include "itensor/all.h"
+#include "clock.h"
+#include "siteops.h"
+#include "hamiltonian.h"
+#include "order.h"
+#include "disorder.h"
+#include "correlator.h"
+#include "ed.h"
+#include "evolution.h"
+#include "metts.h"
+#include "simulations.h"
+#include "campaign.h"
+
+/************************************************************/
+// Templates on the clock order compiled once in instantiations.cc, for
+// N = 2..8 (see dispatch.h) and 1 or 4 excited levels. With
+// CLOCK_PRECOMPILED the programs linking the library only declare them
+// (extern template) instead of compiling them again in every unit.
+/************************************************************/
+
+/// ClockSite<2> is a full specialization, defined in clock.h
+#define CLOCK_SITE_TEMPLATE(EXTERN, N)                                                      \
+    EXTERN template class ClockSite<N>;
+
+#define CLOCK_TEMPLATES(EXTERN, N)                                                          \
+    EXTERN template class SiteOps<N>;                                                       \
+    EXTERN template it::MPO hamiltonian<N>(const Clock<N> &, double, double, double, bool); \
+    EXTERN template it::MPO hamiltonian<N>(const Clock<N> &, const it::Args &);             \
+    EXTERN template it::MPO hamiltonianC<N>(const Clock<N> &, complex, complex, complex, bool); \
+    EXTERN template it::MPO hamiltonianC<N>(const Clock<N> &, const it::Args &);            \
+    EXTERN template it::MPO hamiltonianC<N>(const Clock<N> &, const ChainCouplings &);      \
+    EXTERN template it::MPO hamiltonianC<N>(const Clock<N> &, const SiteCouplings &);       \
+    EXTERN template it::MPO hamiltonian<N>(const Clock<N> &, const std::vector<double> &, const std::vector<double> &, const std::vector<double> &, bool); \
+    EXTERN template it::MPO longitudinal_term<N>(const Clock<N> &, complex);                \
+    EXTERN template double compute_order<N>(const Clock<N> &, it::MPS &, const char *, const char *);        \
+    EXTERN template complex compute_orderC<N>(const Clock<N> &, it::MPS &, const char *, const char *);      \
+    EXTERN template double compute_bulk_order<N>(const Clock<N> &, it::MPS &, const char *, const char *);   \
+    EXTERN template complex compute_bulk_orderC<N>(const Clock<N> &, it::MPS &, const char *, const char *); \
+    EXTERN template it::ITensor compute_disorder_IT<N>(const Clock<N> &, it::MPS &, const string &, const Interval &); \
+    EXTERN template double compute_disorder<N>(const Clock<N> &, it::MPS &, const string &, const Interval &);         \
+    EXTERN template complex compute_disorderC<N>(const Clock<N> &, it::MPS &, const string &, const Interval &);       \
+    EXTERN template complex compute_disorderC<N>(const SiteOps<N> &, it::MPS &, const string &, const Interval &);     \
+    EXTERN template it::ITensor compute_correlator_IT<N>(const Clock<N> &, it::MPS &, const string &, const string &, const Interval &); \
+    EXTERN template double compute_correlator<N>(const Clock<N> &, it::MPS &, const string &, const string &, const Interval &);         \
+    EXTERN template complex compute_correlatorC<N>(const Clock<N> &, it::MPS &, const string &, const string &, const Interval &);       \
+    EXTERN template complex compute_correlatorC<N>(const SiteOps<N> &, it::MPS &, const string &, const string &, const Interval &);     \
+    EXTERN template std::vector<complex> compute_correlatorsC<N>(const SiteOps<N> &, it::MPS &, const string &, const string &, int, int); \
+    EXTERN template class ExactChain<N>;                                                    \
+    EXTERN template class TrotterGates<N>;                                                  \
+    EXTERN template class GateCache<N>;                                                     \
+    EXTERN template class METTS<N>;                                                         \
+    EXTERN template struct simulations::ComputeObservables<N, 1>;                           \
+    EXTERN template struct simulations::ComputeObservables<N, 4>;                           \
+    EXTERN template class simulations::Campaign<N, 1>;                                      \
+    EXTERN template class simulations::Campaign<N, 4>;
+
+#define CLOCK_ALL_TEMPLATES(EXTERN)                                                         \
+    CLOCK_SITE_TEMPLATE(EXTERN, 3) CLOCK_SITE_TEMPLATE(EXTERN, 4)                           \
+    CLOCK_SITE_TEMPLATE(EXTERN, 5) CLOCK_SITE_TEMPLATE(EXTERN, 6)                           \
+    CLOCK_SITE_TEMPLATE(EXTERN, 7) CLOCK_SITE_TEMPLATE(EXTERN, 8)                           \
+    CLOCK_TEMPLATES(EXTERN, 2) CLOCK_TEMPLATES(EXTERN, 3) CLOCK_TEMPLATES(EXTERN, 4)        \
+    CLOCK_TEMPLATES(EXTERN, 5) CLOCK_TEMPLATES(EXTERN, 6) CLOCK_TEMPLATES(EXTERN, 7)        \
+    CLOCK_TEMPLATES(EXTERN, 8)
+
+#if defined(CLOCK_PRECOMPILED) && !defined(CLOCK_INSTANTIATING)
+namespace clocks {
+    CLOCK_ALL_TEMPLATES(extern)
+}
+#endif
+
+#endif
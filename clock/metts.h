@@ -0,0 +1,266 @@
+#ifndef __CLOCK_METTS_H
+#define __CLOCK_METTS_H
+
+#include <array>
+#include <cmath>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <stdexcept>
+
+#include "itensor/all.h"
+#include "clock.h"
+#include "types.h"
+#include "random.h"
+#include "siteops.h"
+#include "hamiltonian.h"
+#include "order.h"
+#include "disorder.h"
+#include "evolution.h"
+
+/************************************************************/
+namespace clocks {
+
+/// Thermal average with its error bar
+struct ThermalEstimate {
+    double mean;
+    double error;
+};
+
+/// Thermal averages at the inverse temperature beta, from the given
+/// number of samples (over all the chains)
+struct ThermalObservables {
+    double beta;
+    unsigned samples;
+    ThermalEstimate energy;
+    ThermalEstimate order;
+    ThermalEstimate transv_order;
+    ThermalEstimate disorder;
+};
+
+///
+/// Minimally entangled typical thermal states (White 2009, Stoudenmire
+/// and White 2010). Each Markov chain evolves a product state |i> in
+/// imaginary time to |phi_i> ~ exp(-beta H/2) |i>, measures it and
+/// collapses it into the next product state with probability
+/// |<i'|phi_i>|^2, alternately in the eigenbasis of X and in the one of
+/// Z, which shortens the autocorrelation of the chain. One of the two is
+/// the basis of ClockSite<N>, where X is diagonal, or Z for N = 2, and
+/// the other one its Fourier basis. The order parameters are measured on the
+/// bulk of the chain, as compute_bulk_orderC, and the disorder operator
+/// on the sites L/4..3L/4, as in the scans.
+/// The chains are independent, each with its own seed, and run
+/// concurrently; the error bars are the standard errors of the means of
+/// the chains, so that they account for the autocorrelation inside each
+/// chain (with a single chain, the naive error of its samples).
+/// Options: "METTSChains" (0: one per worker), "METTSSamples" per chain
+/// (50), "METTSWarmup" samples discarded by each chain (5), "METTSTau"
+/// step of imaginary time (0.05), "Seed" (1), "MaxDim" (100) and "Cutoff"
+/// (1e-10) of the evolution, "TaskThreads", "BlasThreads" (1) and
+/// "PinThreads" as in the scans.
+/// The imaginary time evolution is TEBD with the gates of the cache, or
+/// TDVP with PBC. The sites must not conserve the QNs
+///
+template<unsigned N>
+class METTS {
+public:
+    /// The cache has to outlive the sampler
+    METTS(const GateCache<N> & cache, const ChainCouplings & couplings, const it::Args & args = {});
+
+    /// Thermal averages at the inverse temperature beta
+    ThermalObservables sample(double beta) const;
+
+private:
+    /// Statistics of a single chain
+    struct ChainStats {
+        utils::RunningStats energy, order, transv_order, disorder;
+    };
+
+    const GateCache<N> & cache;
+    const Clock<N> & sites;
+    ChainCouplings couplings;
+    it::MPO H;
+    SiteOps<N> ops;
+    it::Args args;
+    bool x_diagonal;        // X diagonal in the basis of the sites, else Z
+
+    ChainStats run_chain(double beta, unsigned chain) const;
+
+    /// exp(-beta H/2) psi, normalized
+    it::MPS cool(it::MPS psi, double beta) const;
+
+    /// Product state sampled from psi, in the eigenbasis of "X" or "Z"
+    it::MPS collapse(it::MPS & psi, const string & basis, std::mt19937_64 & gen) const;
+
+    /// n-th state of the clock or Fourier basis of the i-th site
+    it::ITensor basis_state(int i, int n, bool fourier) const;
+};
+
+/************************************************************/
+
+template<unsigned N>
+METTS<N>::METTS(const GateCache<N> & cache_, const ChainCouplings & couplings_, const it::Args & args_) :
+    cache(cache_),
+    sites(cache_.sites()),
+    couplings(couplings_),
+    H(hamiltonianC<N>(cache_.sites(), couplings_)),
+    ops(cache_.sites()),
+    args(args_)
+{
+    if (it::hasQNs(sites(1)))
+        throw std::invalid_argument("METTS needs sites without QN conservation");
+    if (!args.defined("MaxDim"))
+        args.add("MaxDim", 100);
+    if (!args.defined("Cutoff"))
+        args.add("Cutoff", 1e-10);
+
+    auto diagonal = [this](const string & name) {
+        auto s = sites(1);
+        const auto & O = ops(name, 1);
+        for (auto n : it::range1(N))
+            for (auto m : it::range1(N))
+                if (n != m && std::abs(it::eltC(O, s(n), it::prime(s)(m))) > 1e-14)
+                    return false;
+        return true;
+    };
+    x_diagonal = diagonal("X");
+    if (x_diagonal == diagonal("Z"))
+        throw std::runtime_error("METTS needs exactly one of X and Z diagonal in the basis of the sites");
+}
+
+template<unsigned N>
+it::ITensor
+METTS<N>::basis_state(int i, int n, bool fourier) const {
+    auto s = sites(i);
+    auto state = it::ITensor(s);
+    if (!fourier) {
+        state.set(s(n+1), 1.0);
+        return state;
+    }
+    for (auto m : it::range(N))
+        state.set(s(m+1), std::polar(1.0 / std::sqrt(double(N)), 2.0 * M_PI * n * m / double(N)));
+    return state;
+}
+
+template<unsigned N>
+it::MPS
+METTS<N>::cool(it::MPS psi, double beta) const {
+    auto tau = args.getReal("METTSTau", 0.05);
+    auto n_steps = std::max(1, int(std::lround(0.5 * beta / tau)));
+    tau = 0.5 * beta / n_steps;
+
+    if (couplings.pbc) {
+        auto solver = detail::TDVP(H, psi);
+        for (auto step = 0; step < n_steps; step++)
+            solver.step(complex(0.0, -tau), args);
+        return detail::Environments::to_mps(psi, solver.M);
+    }
+    auto gates = cache.get(couplings, tau, it::BondGate::tImag);
+    for (auto step = 0; step < n_steps; step++)
+        gates->apply(psi, args);
+    return psi;
+}
+
+template<unsigned N>
+it::MPS
+METTS<N>::collapse(it::MPS & psi, const string & basis, std::mt19937_64 & gen) const {
+    bool fourier = (basis == "X") != x_diagonal;
+    int L = it::length(sites);
+    std::vector<int> config(L);
+    psi.position(1);
+
+    // sample site by site, with the previous sites already projected
+    auto A = psi(1);
+    for (auto i : it::range1(L)) {
+        std::array<it::ITensor, N> projected;
+        std::array<double, N> probs;
+        for (auto n : it::range(N)) {
+            projected[n] = A * it::dag(basis_state(i, n, fourier));
+            probs[n] = std::pow(it::norm(projected[n]), 2);
+        }
+        auto n = std::discrete_distribution<int>(probs.begin(), probs.end())(gen);
+        config[i-1] = n;
+        if (i < L)
+            A = (projected[n] / std::sqrt(probs[n])) * psi(i+1);
+    }
+
+    auto product = product_state(sites, config);
+    if (fourier)
+        for (auto i : it::range1(L)) {
+            auto clock_state = basis_state(i, config[i-1], false);
+            product.ref(i) = (product(i) * it::dag(clock_state)) * basis_state(i, config[i-1], true);
+        }
+    return product;
+}
+
+template<unsigned N>
+typename METTS<N>::ChainStats
+METTS<N>::run_chain(double beta, unsigned chain) const {
+    unsigned warmup  = args.getInt("METTSWarmup", 5);
+    unsigned samples = args.getInt("METTSSamples", 50);
+    int L = it::length(sites);
+
+    auto seeds = std::seed_seq{args.getInt("Seed", 1), int(chain)};
+    auto gen = std::mt19937_64(seeds);
+    auto product = random_product_state(sites, gen);
+
+    ChainStats stats{};
+    for (auto step = 0u; step < warmup + samples; step++) {
+        auto psi = cool(product, beta);
+        if (step >= warmup) {
+            stats.energy.add(it::innerC(psi, H, psi).real());
+            stats.order.add(0.5 * compute_bulk_orderC(sites, psi, "Z", "Zdag").real());
+            stats.transv_order.add(0.5 * compute_bulk_orderC(sites, psi, "X", "Xdag").real());
+            stats.disorder.add(0.5 * (
+                    compute_disorderC(ops, psi, "X",    {L/4, 3*L/4}).real()
+                  + compute_disorderC(ops, psi, "Xdag", {L/4, 3*L/4}).real()
+                ));
+        }
+        product = collapse(psi, step % 2 == 1 ? "Z" : "X", gen);
+    }
+    return stats;
+}
+
+template<unsigned N>
+ThermalObservables
+METTS<N>::sample(double beta) const {
+    if (beta <= 0.0)
+        throw std::invalid_argument("METTS needs a positive inverse temperature");
+
+    auto plan = utils::make_thread_plan(
+            args.getInt("TaskThreads", 0), args.getInt("BlasThreads", 1), args.getBool("PinThreads", false)
+        );
+    unsigned n_chains = args.getInt("METTSChains", 0);
+    if (n_chains == 0)
+        n_chains = plan.workers;
+
+    std::vector<ChainStats> chains(n_chains);
+    #pragma omp parallel for num_threads(plan.workers) schedule(dynamic, 1)
+    for (auto c = 0u; c < n_chains; c++) {
+        utils::ScopedThreadPlan applied(plan, utils::thread_id());
+        chains[c] = run_chain(beta, c);
+    }
+
+    auto estimate = [&chains](utils::RunningStats ChainStats::* field) {
+        if (chains.size() == 1) {
+            const auto & single = chains.front().*field;
+            return ThermalEstimate{single.mean(), single.error()};
+        }
+        utils::RunningStats means{};
+        for (const auto & chain : chains)
+            means.add((chain.*field).mean());
+        return ThermalEstimate{means.mean(), means.error()};
+    };
+    return ThermalObservables{
+        beta,
+        unsigned(n_chains * args.getInt("METTSSamples", 50)),
+        estimate(&ChainStats::energy),
+        estimate(&ChainStats::order),
+        estimate(&ChainStats::transv_order),
+        estimate(&ChainStats::disorder)
+    };
+}
+
+}
+
+#endif
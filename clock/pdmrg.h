@@ -0,0 +1,215 @@
+#ifndef __CLOCK_PDMRG_H
+#define __CLOCK_PDMRG_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+#include "itensor/all.h"
+#include "types.h"
+#include "sweeps.h"
+#include "environments.h"
+
+/************************************************************/
+namespace clocks {
+
+/// Real-space parallel two-site DMRG (Stoudenmire, White 2013).
+/// The chain is split in "Segments" contiguous segments swept concurrently,
+/// even and odd segments in opposite directions, so that neighbouring
+/// segments meet at every other boundary after each half-sweep. There the
+/// bond is optimized with the environments built by the two segments, and
+/// the two sides are glued by V = S^-1, the inverse of the singular values
+/// of the bond, as psi = ... (U S) V (S Vt) ...
+/// Each segment sees the environments of the others as they were at the
+/// last boundary update, so a few more sweeps than the serial DMRG may be
+/// needed. The noise term of the sweeps is not used.
+/// Returns the energy and the ground state, like dmrg(H, psi0, sweeps, args)
+inline std::pair<double, it::MPS>
+pdmrg(const it::MPO & H, const it::MPS & psi0, const it::Sweeps & sweeps, const it::Args & args = {});
+
+/************************************************************/
+
+namespace detail {
+
+///
+/// State of the parallel DMRG: site tensors, environments and the
+/// tensors gluing the segments. Each segment writes only its own
+/// sites and environments, and each boundary only its own bond
+///
+class ParallelDMRG : Environments {
+    std::vector<it::ITensor> V;     // V[k]: inverse singular values at the k-th boundary
+    std::vector<std::pair<unsigned, unsigned>> segments;  // first and last sites
+
+public:
+    ParallelDMRG(const it::MPO & H, const it::MPS & psi0, unsigned n_segments);
+
+    /// Regular DMRG half-sweep from left to right, creating the boundaries
+    void initial_sweep(const it::Args & args);
+
+    /// Sweep of every segment (even to the right if right_even is true,
+    /// odd to the opposite direction), then update of the boundaries
+    /// where the segments meet. Skipped segments stay still
+    void half_sweep(bool right_even, bool skip_even, const it::Args & args);
+
+    /// Glue the segments into a normalized MPS
+    it::MPS state(const it::MPS & psi0) const;
+
+private:
+    void optimize(unsigned b, it::ITensor & phi, const it::Args & args) const;
+    void sweep_right(unsigned first, unsigned last, const it::Args & args);
+    void sweep_left(unsigned first, unsigned last, const it::Args & args);
+    void update_boundary(unsigned k, const it::Args & args);
+
+    static it::ITensor inverse(it::ITensor S);
+};
+
+
+inline
+ParallelDMRG::ParallelDMRG(const it::MPO & H, const it::MPS & psi0, unsigned n_segments) :
+    Environments(H, psi0),
+    V(n_segments > 0 ? n_segments - 1 : 0)
+{
+    if (n_segments < 1 || 2 * n_segments > length)
+        throw std::invalid_argument("Segments of the parallel DMRG need at least two sites");
+
+    for (auto k : it::range(n_segments)) {
+        unsigned first = 1 + (k * length) / n_segments;
+        unsigned last  = ((k + 1) * length) / n_segments;
+        segments.emplace_back(first, last);
+    }
+}
+
+inline it::ITensor
+ParallelDMRG::inverse(it::ITensor S) {
+    S.apply([](it::Real x){ return x > 1e-14 ? 1.0 / x : 0.0; });
+    return S;
+}
+
+inline void
+ParallelDMRG::optimize(unsigned b, it::ITensor & phi, const it::Args & args) const {
+    auto op = it::LocalOp(W[b], W[b+1], LE[b-1], RE[b+2]);
+    it::davidson(op, phi, args);
+}
+
+inline void
+ParallelDMRG::initial_sweep(const it::Args & args) {
+    unsigned k = 0;
+    for (auto b : it::range1(length - 1)) {
+        auto phi = M[b] * M[b+1];
+        optimize(b, phi, args);
+        auto [U, S, Vt] = it::svd(phi, it::uniqueInds(M[b], M[b+1]), args);
+
+        if (k < V.size() && b == segments[k].second) {
+            // boundary: both sides keep the singular values
+            M[b]   = U * S;
+            M[b+1] = S * Vt;
+            V[k]   = inverse(S);
+            LE[b]   = extend_left(b, U);
+            RE[b+1] = extend_right(b+1, Vt);
+            k++;
+        } else {
+            M[b]   = U;
+            M[b+1] = S * Vt;
+            LE[b]  = extend_left(b, U);
+        }
+    }
+}
+
+inline void
+ParallelDMRG::sweep_right(unsigned first, unsigned last, const it::Args & args) {
+    for (auto b = first; b < last; b++) {
+        auto phi = M[b] * M[b+1];
+        optimize(b, phi, args);
+        auto [U, S, Vt] = it::svd(phi, it::uniqueInds(M[b], M[b+1]), args);
+        M[b]   = U;
+        M[b+1] = S * Vt;
+        LE[b]  = extend_left(b, U);
+    }
+}
+
+inline void
+ParallelDMRG::sweep_left(unsigned first, unsigned last, const it::Args & args) {
+    for (auto b = last - 1; b >= first; b--) {
+        auto phi = M[b] * M[b+1];
+        optimize(b, phi, args);
+        auto [U, S, Vt] = it::svd(phi, it::uniqueInds(M[b], M[b+1]), args);
+        M[b]    = U * S;
+        M[b+1]  = Vt;
+        RE[b+1] = extend_right(b+1, Vt);
+    }
+}
+
+inline void
+ParallelDMRG::update_boundary(unsigned k, const it::Args & args) {
+    auto e = segments[k].second, f = e + 1;
+    auto phi = M[e] * V[k] * M[f];
+    optimize(e, phi, args);
+    auto [U, S, Vt] = it::svd(phi, it::uniqueInds(M[e], V[k]), args);
+    M[e]  = U * S;
+    M[f]  = S * Vt;
+    V[k]  = inverse(S);
+    LE[e] = extend_left(e, U);
+    RE[f] = extend_right(f, Vt);
+}
+
+inline void
+ParallelDMRG::half_sweep(bool right_even, bool skip_even, const it::Args & args) {
+    unsigned n_segments = segments.size();
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (auto k = 0u; k < n_segments; k++) {
+        bool even = k % 2 == 0;
+        if (even && skip_even)
+            continue;
+        auto [first, last] = segments[k];
+        if (even == right_even)
+            sweep_right(first, last, args);
+        else
+            sweep_left(first, last, args);
+    }
+
+    // segments meet at the boundaries on the right of the ones
+    // sweeping to the right
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (auto k = 0u; k < V.size(); k++) {
+        bool even = k % 2 == 0;
+        if (even == right_even)
+            update_boundary(k, args);
+    }
+}
+
+inline it::MPS
+ParallelDMRG::state(const it::MPS & psi0) const {
+    // absorb the gluing tensors into the first site of each segment
+    auto tensors = M;
+    for (auto k : it::range(V.size())) {
+        auto f = segments[k].second + 1;
+        tensors[f] = V[k] * M[f];
+    }
+    return to_mps(psi0, tensors);
+}
+
+}
+
+
+inline std::pair<double, it::MPS>
+pdmrg(const it::MPO & H, const it::MPS & psi0, const it::Sweeps & sweeps, const it::Args & args) {
+    auto n_segments = args.getInt("Segments", 2);
+    auto solver = detail::ParallelDMRG(H, psi0, n_segments);
+
+    // After the initial sweep all the segments have their center on the
+    // right, so in the first half-sweep only the odd ones move (to the left)
+    solver.initial_sweep(sweep_args(sweeps, 1));
+    for (auto sw : it::range1(sweeps.nsweep())) {
+        solver.half_sweep(true,  sw == 1, sweep_args(sweeps, sw));
+        solver.half_sweep(false, false,   sweep_args(sweeps, sw));
+    }
+
+    auto psi = solver.state(psi0);
+    return {it::innerC(psi, H, psi).real(), psi};
+}
+
+}
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef __CLOCK_QUEUE_H
+#define __CLOCK_QUEUE_H
+
+#include <set>
+#include <mutex>
+#include <string>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <optional>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+
+#include "types.h"
+
+/************************************************************/
+namespace clocks {
+
+///
+/// Work queue shared by independent processes through a directory.
+/// Each task is a file "tasks/<rank>", holding its description, and the
+/// tasks are claimed in order of rank. A worker claims a task by taking
+/// an exclusive flock on its file and holds it during the computation;
+/// a completed task gets a marker "done/<rank>" before the lock is
+/// released. The kernel releases the lock of a dead worker, so its task
+/// is claimed again by the next worker looking for one.
+/// Works on a local disk or on a shared filesystem (NFS maps flock to
+/// POSIX locks), without any server. POSIX locks belong to the process,
+/// and need a file open for writing: the task files are opened read-write
+/// and read only through the locked descriptor, and the tasks claimed by
+/// the threads of this process are tracked here as well. An error of the
+/// lock other than a task already locked is fatal, since a worker that
+/// cannot lock would otherwise never claim anything
+///
+class WorkQueue {
+    std::filesystem::path dir;
+    std::vector<string> names{};
+    std::set<string> in_progress{};     // claimed by this process
+    std::size_t cursor = 0;
+    std::mutex mtx;
+
+public:
+    /// Claimed task, the lock is held until completed or destroyed
+    class Claim {
+        WorkQueue * queue;
+        int fd;
+        string name_;
+        string description_;
+
+    public:
+        Claim(WorkQueue * queue_, int fd_, const string & name, const string & description) :
+            queue(queue_), fd(fd_), name_(name), description_(description) {}
+        ~Claim() { release(); }
+
+        Claim(const Claim &) = delete;
+        Claim & operator=(const Claim &) = delete;
+        Claim(Claim && other) noexcept :
+            queue(other.queue),
+            fd(std::exchange(other.fd, -1)),
+            name_(std::move(other.name_)),
+            description_(std::move(other.description_)) {}
+
+        const string & name() const { return name_; }
+        const string & description() const { return description_; }
+
+        void release() {
+            if (fd < 0)
+                return;
+            ::close(fd);
+            fd = -1;
+            std::lock_guard<std::mutex> lock(queue->mtx);
+            queue->in_progress.erase(name_);
+        }
+    };
+
+    /// Open an existing queue
+    WorkQueue(const string & directory);
+
+    /// Create a queue with the given tasks, in order of priority.
+    /// The signature identifies the workload, see signature()
+    static void create(
+        const string & directory,
+        const std::vector<string> & tasks,
+        const string & signature
+    );
+
+    /// Signature the queue was created with
+    string signature() const;
+
+    /// Claim the next task neither completed nor in progress, if any
+    std::optional<Claim> claim();
+
+    /// Mark a claimed task as completed and release it
+    void complete(Claim & claim);
+
+    /// Number of tasks, and of the completed ones
+    std::size_t size() const { return names.size(); }
+    std::size_t n_done() const;
+
+private:
+    bool is_done(const string & name) const {
+        return std::filesystem::exists(dir / "done" / name);
+    }
+};
+
+/************************************************************/
+
+inline
+WorkQueue::WorkQueue(const string & directory) : dir(directory) {
+    if (!std::filesystem::is_directory(dir / "tasks"))
+        throw std::runtime_error("No work queue in '" + directory + "'");
+    for (const auto & entry : std::filesystem::directory_iterator(dir / "tasks"))
+        names.push_back(entry.path().filename().string());
+    std::sort(names.begin(), names.end());
+}
+
+inline void
+WorkQueue::create(
+    const string & directory,
+    const std::vector<string> & tasks,
+    const string & signature
+) {
+    auto dir = std::filesystem::path(directory);
+    if (std::filesystem::exists(dir / "tasks"))
+        throw std::runtime_error("Work queue '" + directory + "' already exists");
+
+    // tasks are written in a staging directory, renamed when complete,
+    // so that the workers never see a partial queue
+    auto staging = dir / "tasks.tmp";
+    std::filesystem::remove_all(staging);
+    std::filesystem::create_directories(staging);
+    std::filesystem::create_directories(dir / "done");
+    std::ofstream{dir / "signature"} << signature << std::endl;
+
+    char rank[24];
+    for (std::size_t n = 0; n < tasks.size(); n++) {
+        std::snprintf(rank, sizeof(rank), "%08zu", n);
+        std::ofstream{staging / rank} << tasks[n] << std::endl;
+    }
+    std::filesystem::rename(staging, dir / "tasks");
+}
+
+inline string
+WorkQueue::signature() const {
+    std::ifstream file{dir / "signature"};
+    string sig;
+    std::getline(file, sig);
+    return sig;
+}
+
+inline std::optional<WorkQueue::Claim>
+WorkQueue::claim() {
+    std::lock_guard<std::mutex> lock(mtx);
+    // once around the queue from the cursor, to retry the tasks
+    // released by dead workers
+    for (std::size_t k = 0; k < names.size(); k++) {
+        auto idx = (cursor + k) % names.size();
+        const auto & name = names[idx];
+        if (is_done(name) || in_progress.count(name) > 0)
+            continue;
+
+        auto path = (dir / "tasks" / name).string();
+        int fd = ::open(path.c_str(), O_RDWR);
+        if (fd < 0)
+            throw std::runtime_error("Cannot open task '" + path + "': " + std::strerror(errno));
+        if (::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            auto error = errno;
+            ::close(fd);
+            if (error == EWOULDBLOCK)
+                continue;
+            throw std::runtime_error("Cannot lock task '" + path + "': " + std::strerror(error));
+        }
+        // completed by someone else between the check and the lock
+        if (is_done(name)) {
+            ::close(fd);
+            continue;
+        }
+
+        // from the locked descriptor: closing another one of the same
+        // file would release a POSIX lock
+        string contents{};
+        char buffer[256];
+        for (ssize_t n; (n = ::read(fd, buffer, sizeof(buffer))) > 0; )
+            contents.append(buffer, n);
+        auto description = contents.substr(0, contents.find('\n'));
+        in_progress.insert(name);
+        cursor = idx + 1;
+        return Claim(this, fd, name, description);
+    }
+    return std::nullopt;
+}
+
+inline void
+WorkQueue::complete(Claim & claim) {
+    std::ofstream{dir / "done" / claim.name()} << std::flush;
+    claim.release();
+}
+
+inline std::size_t
+WorkQueue::n_done() const {
+    return std::count_if(names.begin(), names.end(),
+            [this](const string & name){ return is_done(name); });
+}
+
+}
+
+#endif
@@ -9,11 +9,8 @@
 
 namespace clocks {
 
-template<int Mod>
-std::vector<int> random_ints_modulo(unsigned length, int sum) {
-    // Taken directly from cppreference.com
-    std::random_device rd;  //Will be used to obtain a seed for the random number engine
-    std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
+template<int Mod, typename Generator>
+std::vector<int> random_ints_modulo(unsigned length, int sum, Generator & gen) {
     std::uniform_int_distribution<int> distrib(0, Mod-1);
 
     std::vector<int> vec(length);
@@ -25,18 +22,45 @@ std::vector<int> random_ints_modulo(unsigned length, int sum) {
     return vec;
 }
 
+template<int Mod>
+std::vector<int> random_ints_modulo(unsigned length, int sum) {
+    // Taken directly from cppreference.com
+    std::random_device rd;  //Will be used to obtain a seed for the random number engine
+    std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
+    return random_ints_modulo<Mod>(length, sum, gen);
+}
+
+/// Product state of the clock states n_i = 0, ..., N-1 of each site,
+/// named as in state_name
 template<unsigned N>
 it::MPS
-randomMPS_QN(const Clock<N> & sites, int qn) {
-    auto L = it::length(sites);
-    auto random_ints = random_ints_modulo<N>(L, qn);
+product_state(const Clock<N> & sites, const std::vector<int> & config) {
     auto state = it::InitState(sites);
-    for (auto i : it::range1(L)) {
-        state.set(i, std::to_string(random_ints[i-1]));
+    for (auto i : it::range1(it::length(sites))) {
+        state.set(i, state_name<N>(config.at(i-1)));
     }
     return it::MPS(state);
 }
 
+template<unsigned N>
+it::MPS
+randomMPS_QN(const Clock<N> & sites, int qn) {
+    auto L = it::length(sites);
+    return product_state(sites, random_ints_modulo<N>(L, qn));
+}
+
+/// Random product state of clock states, from the given generator,
+/// e.g. seeded for reproducible runs
+template<unsigned N, typename Generator>
+it::MPS
+random_product_state(const Clock<N> & sites, Generator & gen) {
+    std::uniform_int_distribution<int> distrib(0, int(N) - 1);
+    std::vector<int> config(it::length(sites));
+    for (auto & n : config)
+        n = distrib(gen);
+    return product_state(sites, config);
+}
+
 }
 
 
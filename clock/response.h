@@ -0,0 +1,196 @@
+#ifndef __CLOCK_RESPONSE_H
+#define __CLOCK_RESPONSE_H
+
+#include <cmath>
+#include <vector>
+
+#include "itensor/all.h"
+#include "types.h"
+#include "environments.h"
+
+/************************************************************/
+namespace clocks {
+
+/// Correction vector of the ground state psi0 of H, with energy E0, for
+/// the Hermitian perturbation V: the solution of
+///     (H - E0) |x> = - (1 - P0) V |psi0>,     P0 = |psi0><psi0|
+/// orthogonal to psi0, so that the second derivative of the ground state
+/// energy along H + lambda V is 2 Re <psi0|V|x> (for a non-degenerate
+/// ground state).
+/// Two-site sweeps, as in DMRG, where the local linear problem is solved
+/// by conjugate gradient inside the complement of psi0 (Kühner and White
+/// 1999), starting from x0, which must not share the link indices of
+/// psi0, e.g. a random MPS. Options: "ResponseSweeps" (4) sweeps to the
+/// right and back, "ResponseLocalIter" (10) conjugate gradient iterations
+/// per bond, "ResponseTolerance" (1e-10) on the relative local residual,
+/// "MaxDim" and "Cutoff" of the truncation
+inline it::MPS
+correction_vector(
+    const it::MPO & H,
+    const it::MPO & V,
+    const it::MPS & psi0,
+    double energy,
+    const it::MPS & x0,
+    const it::Args & args = {}
+);
+
+/************************************************************/
+
+namespace detail {
+
+///
+/// Sweeps of the correction vector: the environments of H on the
+/// correction vector, and the ones of V|psi0> and psi0 projected on its
+/// basis
+///
+class CorrectionVector : public Environments {
+public:
+    CorrectionVector(const it::MPO & H, const it::MPO & V, const it::MPS & psi0, double energy, const it::MPS & x0);
+
+    /// Solve on the bond (b, b+1) and move the center to the right (or left)
+    void step(unsigned b, bool to_right, const it::Args & args);
+
+private:
+    double energy;
+    complex v0;                         // <psi0|V|psi0>
+    std::vector<it::ITensor> V, P;      // perturbation and psi0, 1..L
+    std::vector<it::ITensor> VL, VR;    // environments of <x|V|psi0>
+    std::vector<it::ITensor> OL, OR;    // environments of <x|psi0>
+
+    void update_left(unsigned j);
+    void update_right(unsigned j);
+};
+
+// E * T, with an empty environment at the ends of the chain
+inline it::ITensor attach(const it::ITensor & E, const it::ITensor & T) {
+    return E ? E * T : T;
+}
+
+inline
+CorrectionVector::CorrectionVector(
+    const it::MPO & H,
+    const it::MPO & V_,
+    const it::MPS & psi0,
+    double energy_,
+    const it::MPS & x0
+) :
+    Environments(H, x0),
+    energy(energy_),
+    v0(it::innerC(psi0, V_, psi0)),
+    V(length + 2), P(length + 2),
+    VL(length + 2), VR(length + 2), OL(length + 2), OR(length + 2)
+{
+    for (auto j : it::range1(length)) {
+        V[j] = V_(j);
+        P[j] = psi0(j);
+    }
+    for (auto j = length; j >= 2; j--)
+        update_right(j);
+}
+
+inline void
+CorrectionVector::update_left(unsigned j) {
+    VL[j] = attach(VL[j-1], P[j]) * V[j] * it::dag(it::prime(M[j]));
+    OL[j] = attach(OL[j-1], P[j]) * it::dag(M[j]);
+}
+
+inline void
+CorrectionVector::update_right(unsigned j) {
+    VR[j] = attach(VR[j+1], P[j]) * V[j] * it::dag(it::prime(M[j]));
+    OR[j] = attach(OR[j+1], P[j]) * it::dag(M[j]);
+}
+
+inline void
+CorrectionVector::step(unsigned b, bool to_right, const it::Args & args) {
+    auto max_iter = args.getInt("ResponseLocalIter", 10);
+    auto tol = args.getReal("ResponseTolerance", 1e-10);
+
+    // psi0 and V|psi0> in the basis of the bond
+    auto ground = attach(OL[b-1], P[b]) * P[b+1];
+    ground = attach(OR[b+2], ground);
+    auto perturbed = attach(VL[b-1], P[b]) * V[b] * P[b+1] * V[b+1];
+    perturbed = it::noPrime(attach(VR[b+2], perturbed));
+
+    // (1 - P0) on the bond, with psi0 only partially in its basis
+    auto ground_norm2 = std::pow(it::norm(ground), 2);
+    auto project = [&ground, ground_norm2](it::ITensor & T) {
+        if (ground_norm2 > 0.0)
+            T -= (it::eltC(it::dag(ground) * T) / ground_norm2) * ground;
+    };
+    auto op = it::LocalOp(W[b], W[b+1], LE[b-1], RE[b+2]);
+    auto apply = [&](const it::ITensor & T) {
+        it::ITensor HT;
+        op.product(T, HT);
+        HT -= energy * T;
+        project(HT);
+        return HT;
+    };
+
+    auto rhs = -(perturbed - v0 * ground);
+    project(rhs);
+    auto x = M[b] * M[b+1];
+    project(x);
+
+    // conjugate gradient, (H - E0) is positive in the complement of psi0
+    auto r = rhs - apply(x);
+    auto p = r;
+    auto rr = std::pow(it::norm(r), 2);
+    auto rhs_norm = it::norm(rhs);
+    for (auto iter = 0; iter < max_iter && std::sqrt(rr) > tol * rhs_norm; iter++) {
+        auto Ap = apply(p);
+        auto pAp = it::eltC(it::dag(p) * Ap).real();
+        if (pAp <= 0.0)
+            break;
+        x += (rr / pAp) * p;
+        r -= (rr / pAp) * Ap;
+        auto rr_new = std::pow(it::norm(r), 2);
+        p = r + (rr_new / rr) * p;
+        rr = rr_new;
+    }
+
+    auto [U, S, Vt] = it::svd(x, it::uniqueInds(M[b], M[b+1]), args);
+    if (to_right) {
+        M[b]   = U;
+        M[b+1] = S * Vt;
+        LE[b]  = extend_left(b, M[b]);
+        update_left(b);
+    } else {
+        M[b]    = U * S;
+        M[b+1]  = Vt;
+        RE[b+1] = extend_right(b+1, M[b+1]);
+        update_right(b+1);
+    }
+}
+
+}
+
+
+inline it::MPS
+correction_vector(
+    const it::MPO & H,
+    const it::MPO & V,
+    const it::MPS & psi0,
+    double energy,
+    const it::MPS & x0,
+    const it::Args & args
+) {
+    auto solver = detail::CorrectionVector(H, V, psi0, energy, x0);
+    auto length = solver.length;
+
+    for (auto sw = 0; sw < args.getInt("ResponseSweeps", 4); sw++) {
+        for (auto b = 1u; b < length; b++)
+            solver.step(b, true, args);
+        for (auto b = length - 1; b >= 1; b--)
+            solver.step(b, false, args);
+    }
+
+    // not normalized, unlike Environments::to_mps
+    auto x = x0;
+    for (auto j : it::range1(length))
+        x.set(j, solver.M[j]);
+    return x;
+}
+
+}
+
+#endif
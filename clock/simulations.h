@@ -1,12 +1,16 @@
 #ifndef __CLOCK_SIMULATIONS_H
 #define __CLOCK_SIMULATIONS_H
 
+#include <cmath>
 #include <vector>
 #include <array>
 #include <string>
 #include <utility>
 #include <stdexcept>
 #include <optional>
+#include <memory>
+#include <random>
+#include <sstream>
 
 #include "itensor/all.h"
 #include "./all.h"
@@ -55,15 +59,18 @@ struct Observables {
     optional<double> correlator_half;
     optional<Vector> correlator;
     optional<Vector> excited_energies;
+    optional<double> phase_response;
+    optional<double> phase_curvature;
 };
 
 
-template<unsigned N, unsigned n_points, unsigned n_excited = 1>
+template<unsigned N, unsigned n_excited = 1>
 struct ComputeObservables {
 
     // Types
-    using Array = std::array<double, n_points>;
+    using Array = std::vector<double>;
     using Table = ut::Table<Array>;
+    using Handle = typename Table::handle_type;
 
     // Members
     Clock<N> sites;
@@ -71,6 +78,8 @@ struct ComputeObservables {
     Array couplings;
     it::Sweeps sweeps;
     it::Args args;
+    cl::SiteOps<N> ops;     // site operators shared by all the measurements
+    cl::GateCache<N> gates; // Trotter gates shared by all the time evolutions
 
     /// Constructor
     /// needs chain length, sweeps and couplings
@@ -84,33 +93,49 @@ struct ComputeObservables {
         size(chain_length_),
         couplings(couplings_),
         sweeps(sweeps_),
-        args(args_) {};
+        args(args_),
+        ops(sites),
+        gates(sites) {};
+
+    // Excited level, as energy and wavefunction
+    using Level = pair<double, it::MPS>;
+
+    /// Phase of the twist in the longitudinal term
+    complex twist_phase(unsigned sector) {
+        double phase_noise = args.getReal("PhaseNoise", 0.);
+        return exp(complex(0.0, 2.0 * M_PI * (sector + phase_noise) / double(N)));
+    }
+
+    /// Couplings of the dual Clock Hamiltonian
+    cl::ChainCouplings dual_couplings(double coupling, unsigned sector) {
+        complex longit_factor = 1.0 + twist_phase(sector);
+        return {- coupling, - 1.0, - coupling * longit_factor, args.getBool("PBC", false)};
+    }
 
     /// Dual Clock Hamiltonian
     auto dual_hamiltonian(double coupling, unsigned sector) {
-        double phase_noise = args.getReal("PhaseNoise", 0.);
-        complex phase = exp(complex(0.0, 2.0 * M_PI * (sector + phase_noise) / double(N)));
-        complex longit_factor = 1.0 + phase;
-        return hamiltonianC<N>(sites, {
-                "Kinetic",  - coupling,
-                "Transv",   - 1.0,
-                "LongitRe", - coupling * longit_factor.real(),
-                "LongitIm", - coupling * longit_factor.imag(),
-                "PBC",      args.getBool("PBC", false)
-            });
+        ut::ScopedTimer scope("hamiltonian");
+        return hamiltonianC<N>(sites, dual_couplings(coupling, sector));
+    }
+
+    /// Key of the ground state at the given coupling in the MPS store
+    cl::StateKey state_key(double coupling, unsigned sector) {
+        return {N, size, coupling, sector, point_hash(coupling, sector)};
     }
 
     /// Disorder operator, equivalent to the Wilson loop
     optional<double> disorder(it::MPS & psi) {
+        ut::ScopedTimer scope("disorder");
         if (args.getBool("NoDisorder", false))
             return std::nullopt;
         return 0.5 * (
-                    cl::compute_disorderC(sites, psi, "X",    {size/4, 3*size/4}).real()
-                  + cl::compute_disorderC(sites, psi, "Xdag", {size/4, 3*size/4}).real()
+                    cl::compute_disorderC(ops, psi, "X",    {size/4, 3*size/4}).real()
+                  + cl::compute_disorderC(ops, psi, "Xdag", {size/4, 3*size/4}).real()
                 );
     };
 
     optional<double> order(it::MPS & psi) {
+        ut::ScopedTimer scope("order");
         if (args.getBool("NoOrder", false))
             return std::nullopt;
         if (args.getBool("OnlyBulk", false))
@@ -120,6 +145,7 @@ struct ComputeObservables {
     }
 
     optional<double> transv_order(it::MPS & psi) {
+        ut::ScopedTimer scope("transv_order");
         if (args.getBool("NoTransvOrder", false))
             return std::nullopt;
         if (args.getBool("OnlyBulk", false))
@@ -131,36 +157,41 @@ struct ComputeObservables {
 
     /// Correlator from the start to the middle of the chain, equivalent to the 't Hooft string
     optional<double> half_chain_correlator(it::MPS & psi) {
+        ut::ScopedTimer scope("half_chain_correlator");
         if (args.getBool("NoHalfChainCorrelator", false))
             return std::nullopt;
-        return abs(cl::compute_correlatorC(sites, psi, "Z", "Zdag", {1, size/2}));
+        return abs(cl::compute_correlatorC(ops, psi, "Z", "Zdag", {1, size/2}));
     };
 
     /// Compute correlator on a given range inside the chain
     optional<Vector> correlator(it::MPS & psi, unsigned begin, unsigned end){
+        ut::ScopedTimer scope("correlator");
         if (args.getBool("NoCorrelator", false))
             return {};
         if (begin >= end)
             throw std::invalid_argument("`begin` must be strictly smaller than `end`");
 
+        // all the distances from a single environment
         Vector corr_values{};
-        corr_values.reserve(end - begin);
-        for (auto pos : ut::range(begin+1, end))
-            corr_values.emplace_back(
-                    abs(cl::compute_correlatorC(sites, psi, "Z", "Zdag", {begin, pos}))
-                );
+        if (end == begin + 1)
+            return corr_values;
+        corr_values.reserve(end - begin - 1);
+        for (auto value : cl::compute_correlatorsC(ops, psi, "Z", "Zdag", begin, end - 1))
+            corr_values.push_back(abs(value));
         return corr_values;
     };
 
-    /// Compute energy of the excited levels
-    optional<Vector>
-    excited_levels(
+    /// Compute the excited levels, energies and wavefunctions
+    std::vector<Level>
+    excited_states(
         it::MPO & hamiltonian,
         it::MPS & psi0
     ) {
+        ut::ScopedTimer scope("excited_states");
         if (args.getBool("NoExcited", false) || n_excited == 0)
             return {};
-        Vector excited_energies(n_excited);
+        auto levels = std::vector<Level>{};
+        levels.reserve(n_excited);
         auto wavefunctions = std::vector<it::MPS>{};
         wavefunctions.reserve(n_excited);
         wavefunctions.push_back(psi0);
@@ -172,24 +203,187 @@ struct ComputeObservables {
                     wavefunctions,
                     init_psi,
                     sweeps,
-                    {"Silent", true, "Weight", 10.0}
+                    dmrg_args({"Weight", 10.0})
                 );
-            excited_energies.at(n) = E;
+            levels.emplace_back(E, psi);
             wavefunctions.push_back(psi);
         }
 
-        return excited_energies;
+        return levels;
     };
 
-    /// Compute the observables for a given coupling and sector
+    /// Energy of the excited levels
+    optional<Vector> excited_levels(const std::vector<Level> & levels) {
+        if (levels.empty())
+            return {};
+        Vector excited_energies{};
+        excited_energies.reserve(levels.size());
+        for (const auto & level : levels)
+            excited_energies.push_back(level.first);
+        return excited_energies;
+    }
+
+    /// Derivatives of the dual Hamiltonian with respect to the phase
+    /// noise, as the longitudinal couplings of the first and second one
+    pair<complex, complex> phase_derivatives(double coupling, unsigned sector) {
+        // longitudinal coupling - coupling * (1 + phase)
+        auto dphase = complex(0.0, 2.0 * M_PI / double(N));
+        auto phase  = twist_phase(sector);
+        return {- coupling * dphase * phase, - coupling * dphase * dphase * phase};
+    }
+
+    /// Linear response of the ground state energy to the phase noise,
+    /// evaluated at the unperturbed ground state.
+    /// First derivative from Hellmann-Feynman, <dH>, second derivative
+    /// as <d2H> + 2 Re <0|dH|x>, with the correction vector x solving
+    /// (H - E0)|x> = - (1 - P0) dH|0>, see response.h. Its sweeps are
+    /// truncated as the last sweep of the ground state
+    pair<optional<double>, optional<double>>
+    phase_response(
+        double coupling,
+        unsigned sector,
+        it::MPO & H,
+        it::MPS & psi0,
+        double gs_energy
+    ) {
+        ut::ScopedTimer scope("phase_response");
+        if (!args.getBool("LinearResponse", false))
+            return {std::nullopt, std::nullopt};
+
+        auto [c1, c2] = phase_derivatives(coupling, sector);
+        auto dH  = cl::longitudinal_term<N>(sites, c1);
+        auto d2H = cl::longitudinal_term<N>(sites, c2);
+
+        auto response_args = cl::sweep_args(sweeps, sweeps.nsweep());
+        for (auto opt : {"ResponseSweeps", "ResponseLocalIter"})
+            if (args.defined(opt))
+                response_args.add(opt, args.getInt(opt));
+        if (args.defined("ResponseTolerance"))
+            response_args.add("ResponseTolerance", args.getReal("ResponseTolerance"));
+        auto x = cl::correction_vector(H, dH, psi0, gs_energy, it::randomMPS(sites), response_args);
+
+        double first  = it::innerC(psi0, dH, psi0).real();
+        double second = it::innerC(psi0, d2H, psi0).real() + 2.0 * it::innerC(psi0, dH, x).real();
+        return {first, second};
+    }
+
+    /// Options of the DMRG runs. With "SpillDim" the environments are kept
+    /// on disk, in "ScratchDir", for the sweeps with at least that bond
+    /// dimension, trading memory for I/O in the large bond dimension stages.
+    /// Only the two-site DMRG spills, through the WriteDim of ITensor, which
+    /// reads the environments back synchronously (no prefetch)
+    it::Args dmrg_args(it::Args extra = {}) const {
+        extra.add("Silent", true);
+        if (args.defined("SpillDim")) {
+            extra.add("WriteDim", args.getInt("SpillDim"));
+            extra.add("WriteDir", args.getString("ScratchDir", "./"));
+        }
+        return extra;
+    }
+
+    /// Ground state by DMRG. The sweeps from "SingleSiteFrom" on (counting
+    /// from 1) are single-site with subspace expansion, see dmrg1.h, with
+    /// "ExpansionAlpha" for the sweeps without noise
+    pair<double, it::MPS>
+    ground_state(
+        it::MPO & H,
+        double coupling,
+        unsigned sector
+    ) {
+        ut::ScopedTimer scope("ground_state");
+        int single_from = args.getInt("SingleSiteFrom", 0);
+        if (single_from < 1 || single_from > sweeps.nsweep())
+            return two_site_ground_state(H, coupling, sector, sweeps);
+
+        auto psi = single_from > 1
+            ? two_site_ground_state(H, coupling, sector, cl::sweeps_range(sweeps, 1, single_from-1)).second
+            : it::randomMPS(sites);
+        auto energy = cl::dmrg1(
+                psi, H, cl::sweeps_range(sweeps, single_from),
+                {"Alpha", args.getReal("ExpansionAlpha", 1e-6)}
+            );
+        return {energy, psi};
+    }
+
+    /// Ground state by two-site DMRG with the given sweeps. With
+    /// "CheckpointSweeps" the state is saved next to the "Checkpoint" file
+    /// after each sweep, and a calculation interrupted by a killed job
+    /// resumes from the last saved sweep.
+    /// With "ParallelSegments" > 1 the chain is instead split in segments
+    /// swept concurrently (real-space parallel DMRG, see pdmrg.h), which
+    /// supports neither "SpillDim", "CheckpointSweeps" nor sweeps with
+    /// noise: these combinations throw
+    pair<double, it::MPS>
+    two_site_ground_state(
+        it::MPO & H,
+        double coupling,
+        unsigned sector,
+        const it::Sweeps & stage
+    ) {
+        if (args.getInt("ParallelSegments", 1) > 1) {
+            if (args.defined("SpillDim"))
+                throw std::invalid_argument("\"SpillDim\" is not supported with \"ParallelSegments\"");
+            if (args.getBool("CheckpointSweeps", false))
+                throw std::invalid_argument("\"CheckpointSweeps\" is not supported with \"ParallelSegments\"");
+            for (auto sw : it::range1(stage.nsweep()))
+                if (stage.noise(sw) != 0.0)
+                    throw std::invalid_argument("Sweeps with noise are not supported with \"ParallelSegments\"");
+            return cl::pdmrg(H, it::randomMPS(sites), stage, {"Segments", args.getInt("ParallelSegments")});
+        }
+
+        if (!args.getBool("CheckpointSweeps", false) || !args.defined("Checkpoint")) {
+            auto [energy, psi] = dmrg(H, it::randomMPS(sites), stage, dmrg_args());
+            return {energy, psi};
+        }
+
+        auto base = args.getString("Checkpoint") + "." + point_hash(coupling, sector);
+        auto psi = it::randomMPS(sites);
+        int done = 0;
+        if (auto partial = cl::load_partial_state(base)) {
+            std::tie(psi, done) = partial.value();
+            // restore the site indices of this object
+            psi.replaceSiteInds(sites.inds());
+        }
+
+        double energy;
+        if (done < stage.nsweep()) {
+            auto observer = cl::CheckpointObserver(psi, base, done);
+            energy = dmrg(psi, H, cl::sweeps_range(stage, done+1), observer, dmrg_args());
+        } else {
+            energy = it::innerC(psi, H, psi).real();
+        }
+        cl::remove_partial_state(base);
+        return {energy, psi};
+    }
+
+    /// Compute the observables for a given coupling and sector, by exact
+    /// diagonalization for chains up to "EDThreshold" sites
     pair<optional<Observables>, it::MPS>
     observables_at(
         double coupling,
         unsigned sector
     ) {
+        if (uses_ed())
+            return ed_observables_at(cl::SiteCouplings(size, dual_couplings(coupling, sector)), coupling, sector);
         auto H = dual_hamiltonian(coupling, sector);
-        auto init_psi = it::randomMPS(sites);
-        auto [gs_energy, psi] = dmrg(H, init_psi, sweeps, {"Silent", true});
+        return dmrg_observables(H, coupling, sector);
+    };
+
+    /// Observables of the ground state of H found by DMRG, where H is the
+    /// dual Hamiltonian at coupling and sector, or one of its disorder
+    /// realizations (with_response = false, see disorder_average)
+    pair<optional<Observables>, it::MPS>
+    dmrg_observables(
+        it::MPO & H,
+        double coupling,
+        unsigned sector,
+        bool with_response = true
+    ) {
+        auto [gs_energy, psi] = ground_state(H, coupling, sector);
+        auto levels = excited_states(H, psi);
+        auto [response, curvature] = with_response
+            ? phase_response(coupling, sector, H, psi, gs_energy)
+            : pair<optional<double>, optional<double>>{};
         auto results = Observables{
             gs_energy,
             disorder(psi),
@@ -197,40 +391,683 @@ struct ComputeObservables {
             transv_order(psi),
             half_chain_correlator(psi),
             correlator(psi, size/4, 3*size/4),
-            excited_levels(H, psi)
+            excited_levels(levels),
+            response,
+            curvature
         };
 
         return std::make_pair(results, psi);
     };
 
+    /// Quench from the ground state at coupling to the dual Hamiltonian at
+    /// quench_coupling, in the same sector: "QuenchSteps" steps (100) of
+    /// "QuenchDt" (0.05), measuring the energy and the enabled observables
+    /// every "MeasureEvery" steps (1), see evolution.h. "Evolution" is
+    /// "TEBD" (default) or "TDVP", always TDVP with PBC, truncated to
+    /// "EvolutionMaxDim" (the largest of the sweeps) and "EvolutionCutoff"
+    Table quench(double coupling, double quench_coupling, unsigned sector) {
+        unsigned n_steps = args.getInt("QuenchSteps", 100);
+        unsigned every   = args.getInt("MeasureEvery", 1);
+        double dt        = args.getReal("QuenchDt", 0.05);
+        if (every == 0)
+            throw std::invalid_argument("\"MeasureEvery\" must be positive");
+
+        auto schema = std::vector<string>{"time", "energy"};
+        const auto opts_cols = std::vector<pair<string, string>>{
+            {"NoDisorder", "disorder"},
+            {"NoOrder", "order"},
+            {"NoTransvOrder", "transv_order"},
+            {"NoHalfChainCorrelator", "corr_half"}
+        };
+        for (const auto & [opt, col] : opts_cols)
+            if (!args.getBool(opt, false))
+                schema.push_back(col);
+        unsigned n_rows = n_steps / every + 1 + (n_steps % every != 0 ? 1 : 0);
+        auto table = Table(schema, n_rows);
+        auto set = [&table](const string & id, unsigned row, optional<double> value) {
+            if (value)
+                table[id][row] = value.value();
+        };
+
+        auto psi0 = observables_at(coupling, sector).second;
+        auto H = dual_hamiltonian(quench_coupling, sector);
+        unsigned row = 0;
+        auto measure = [&](unsigned, double time, it::MPS & psi) {
+            ut::ScopedTimer scope("quench_measurement");
+            table["time"][row]   = time;
+            table["energy"][row] = it::innerC(psi, H, psi).real();
+            set("disorder",     row, disorder(psi));
+            set("order",        row, order(psi));
+            set("transv_order", row, transv_order(psi));
+            set("corr_half",    row, half_chain_correlator(psi));
+            row++;
+        };
+
+        ut::ScopedTimer scope("quench");
+        cl::evolve(gates, dual_couplings(quench_coupling, sector), psi0, dt, n_steps, measure, {
+                "Method",       args.getString("Evolution", "TEBD"),
+                "MeasureEvery", int(every),
+                "MaxDim",       args.getInt("EvolutionMaxDim", cl::max_dim(sweeps)),
+                "Cutoff",       args.getReal("EvolutionCutoff", 1e-10)
+            });
+        return table;
+    }
+
+    /// Thermal averages at the inverse temperature beta for all the
+    /// couplings, by METTS (see metts.h) with the options of args, and
+    /// "EvolutionMaxDim" and "EvolutionCutoff" as for the quenches. Each
+    /// average comes with its error bar in the column "<name>_err"
+    Table thermal(unsigned sector, double beta) {
+        const auto names = std::vector<string>{"energy", "order", "transv_order", "disorder"};
+        auto schema = std::vector<string>{"couplings"};
+        for (const auto & name : names) {
+            schema.push_back(name);
+            schema.push_back(name + "_err");
+        }
+        auto table = Table(schema, couplings.size());
+
+        auto metts_args = args;
+        metts_args.add("MaxDim", args.getInt("EvolutionMaxDim", cl::max_dim(sweeps)));
+        metts_args.add("Cutoff", args.getReal("EvolutionCutoff", 1e-10));
+        for (auto i : ut::range(couplings.size())) {
+            print_progress(i + 1, couplings.size());
+            ut::ScopedTimer scope("metts");
+            auto metts = cl::METTS<N>(gates, dual_couplings(couplings[i], sector), metts_args);
+            auto obs = metts.sample(beta);
+            auto estimates = {obs.energy, obs.order, obs.transv_order, obs.disorder};
+            table["couplings"][i] = couplings[i];
+            auto name = names.begin();
+            for (const auto & [mean, error] : estimates) {
+                table[*name][i] = mean;
+                table[*name + "_err"][i] = error;
+                name++;
+            }
+        }
+        std::cout << " Done!\n";
+        return table;
+    }
+
+    /// Averages over quenched disorder of the observables, for all the
+    /// couplings. Each of the "Realizations" (100) is the dual Hamiltonian
+    /// with its site couplings multiplied by 1 + W u, with u uniform in
+    /// [-1, 1], independent on each site and term, and W given by
+    /// "KineticDisorder", "TransvDisorder" and "LongitDisorder" (0).
+    /// The r-th realization is drawn from the seeds ("Seed", r), so that
+    /// it is the same at every coupling and in every run. The realizations
+    /// run concurrently as the points of the scans (see thread_plan), and
+    /// each is folded into the running mean and variance ("<column>_var")
+    /// of every column as it completes, so that the memory does not grow
+    /// with the number of realizations.
+    /// The linear response is not computed, and "CheckpointSweeps" is not
+    /// supported. Throws without couplings or realizations
+    Table disorder_average(unsigned sector) {
+        if (args.getBool("CheckpointSweeps", false))
+            throw std::invalid_argument("\"CheckpointSweeps\" is not supported by the disorder averages");
+        if (couplings.empty())
+            throw std::invalid_argument("Disorder averages need at least one coupling");
+        if (args.getInt("Realizations", 100) <= 0)
+            throw std::invalid_argument("\"Realizations\" must be positive");
+        unsigned n_couplings    = couplings.size();
+        unsigned n_realizations = args.getInt("Realizations", 100);
+        unsigned done = 0;
+        auto plan = thread_plan();
+        auto timer = ut::Timer().start();
+
+        using Stats = std::vector<pair<string, ut::RunningStats>>;
+        auto stats = std::vector<Stats>(n_couplings);
+
+        #pragma omp parallel for num_threads(plan.workers) schedule(dynamic, 1) collapse(2)
+        for (auto i = 0u; i < n_couplings; i++)
+            for (auto r = 0u; r < n_realizations; r++) {
+                ut::ScopedThreadPlan applied(plan, ut::thread_id());
+                auto site_couplings = random_couplings(couplings[i], sector, r);
+                auto values = observable_values(realization_at(site_couplings, couplings[i], sector));
+                #pragma omp critical
+                {
+                    print_progress(++done, n_couplings * n_realizations);
+                    auto & acc = stats[i];
+                    if (acc.empty())
+                        for (const auto & [id, value] : values)
+                            acc.emplace_back(id, ut::RunningStats{});
+                    for (auto k : ut::range(values.size()))
+                        acc[k].second.add(values[k].second);
+                }
+            }
+        std::cout << " Done!\n";
+        std::cout << "   Elapsed time: " << timer.stop() << "\n";
+
+        auto schema = std::vector<string>{"couplings", "realizations"};
+        for (const auto & [id, acc] : stats.front()) {
+            schema.push_back(id);
+            schema.push_back(id + "_var");
+        }
+        auto table = Table(schema, n_couplings, std::nan(""));
+        table["couplings"] = couplings;
+        for (auto i : ut::range(n_couplings)) {
+            table["realizations"][i] = n_realizations;
+            for (const auto & [id, acc] : stats[i]) {
+                table[id][i] = acc.mean();
+                table[id + "_var"][i] = acc.variance();
+            }
+        }
+        return table;
+    }
+
+    /// Site couplings of the r-th disorder realization of the dual
+    /// Hamiltonian at coupling and sector, see disorder_average
+    cl::SiteCouplings random_couplings(double coupling, unsigned sector, unsigned realization) {
+        auto site_couplings = cl::SiteCouplings(size, dual_couplings(coupling, sector));
+        auto seeds = std::seed_seq{args.getInt("Seed", 1), int(realization)};
+        auto gen = std::mt19937_64(seeds);
+        auto box = std::uniform_real_distribution<double>(-1.0, 1.0);
+        // always drawn, so that each term sees the same numbers whatever the other widths
+        auto perturb = [&gen, &box](std::vector<complex> & values, double width) {
+            for (auto & value : values)
+                value *= 1.0 + width * box(gen);
+        };
+        perturb(site_couplings.kinet,  args.getReal("KineticDisorder", 0.));
+        perturb(site_couplings.transv, args.getReal("TransvDisorder", 0.));
+        perturb(site_couplings.longit, args.getReal("LongitDisorder", 0.));
+        return site_couplings;
+    }
+
+    /// Observables of the ground state with the given site couplings, by
+    /// exact diagonalization or DMRG as in observables_at
+    Observables realization_at(const cl::SiteCouplings & site_couplings, double coupling, unsigned sector) {
+        ut::ScopedTimer scope("realization");
+        if (uses_ed())
+            return ed_observables_at(site_couplings, coupling, sector, false).first.value();
+        auto H = [&]() {
+            ut::ScopedTimer build("hamiltonian");
+            return hamiltonianC<N>(sites, site_couplings);
+        }();
+        return dmrg_observables(H, coupling, sector, false).first.value();
+    }
+
+    /// Values of the observables, as pairs (column id, value) named as
+    /// the columns of the scans
+    static std::vector<pair<string, double>> observable_values(const Observables & obs) {
+        auto values = std::vector<pair<string, double>>{{"gs_energy", obs.gs_energy}};
+        const auto scalars = std::array<pair<string, optional<double>>, 4>{{
+            {"disorder",     obs.disorder},
+            {"order",        obs.order},
+            {"transv_order", obs.transv_order},
+            {"corr_half",    obs.correlator_half}
+        }};
+        for (const auto & [id, value] : scalars)
+            if (value)
+                values.emplace_back(id, value.value());
+        if (obs.excited_energies)
+            for (auto n : ut::range(obs.excited_energies->size()))
+                values.emplace_back("E" + str(n+1), obs.excited_energies->at(n));
+        if (obs.correlator)
+            for (auto r : ut::range(obs.correlator->size()))
+                values.emplace_back("corr_R_" + str(r+1), obs.correlator->at(r));
+        return values;
+    }
+
+    /// Whether the points are computed by exact diagonalization: up to
+    /// "EDThreshold" sites, if the Lanczos vectors fit in "EDMaxMemory"
+    bool uses_ed() const {
+        unsigned n_levels = 1 + (args.getBool("NoExcited", false) ? 0 : n_excited);
+        return int(size) <= args.getInt("EDThreshold", 0)
+            && cl::ExactChain<N>::memory_mb(size, n_levels, args) <= args.getReal("EDMaxMemory", 4096.);
+    }
+
+    /// Same observables of observables_at, from the exact levels of the
+    /// dual Hamiltonian with the given site couplings (see ed.h), resolved
+    /// by charge and momentum when the Hamiltonian has these symmetries.
+    /// The linear response assumes the uniform couplings of the coupling
+    /// and sector, and is skipped with with_response = false
+    pair<optional<Observables>, it::MPS>
+    ed_observables_at(
+        const cl::SiteCouplings & site_couplings,
+        double coupling,
+        unsigned sector,
+        bool with_response = true
+    ) {
+        ut::ScopedTimer scope("exact_diagonalization");
+        auto chain = cl::ExactChain<N>(site_couplings, args);
+        unsigned n_levels = args.getBool("NoExcited", false) ? 0 : n_excited;
+        auto levels = chain.lowest(1 + n_levels);
+        const auto & [gs_energy, gs] = levels.front();
+
+        using OpString = typename cl::ExactChain<N>::OpString;
+        auto expect = [&](const OpString & ops) { return chain.expectation(gs, ops, gs); };
+        auto site_average = [&](const string & op1, const string & op2) {
+            bool bulk = args.getBool("OnlyBulk", false);
+            unsigned first = bulk ? size/4 : 1, last = bulk ? 3*size/4 : size;
+            complex total = 0.0;
+            for (auto i : ut::range(first, last + 1))
+                total += expect({{op1, i}}) + expect({{op2, i}});
+            return 0.5 * total.real() / double(last - first + 1);
+        };
+        auto string_of = [&](const string & op, unsigned begin, unsigned end) {
+            OpString ops{};
+            for (auto i : ut::range(begin, end + 1))
+                ops.emplace_back(op, i);
+            return ops;
+        };
+        // sum_i c Z_i + conj(c) Zdag_i between two levels
+        auto longitudinal = [&](complex c, const cl::EDVector & bra, const cl::EDVector & ket) {
+            complex total = 0.0;
+            for (auto i : it::range1(size))
+                total += c * chain.expectation(bra, {{"Z", i}}, ket)
+                       + std::conj(c) * chain.expectation(bra, {{"Zdag", i}}, ket);
+            return total;
+        };
+
+        auto results = Observables{gs_energy};
+        if (!args.getBool("NoDisorder", false))
+            results.disorder = 0.5 * (
+                    expect(string_of("X",    size/4, 3*size/4)).real()
+                  + expect(string_of("Xdag", size/4, 3*size/4)).real()
+                );
+        if (!args.getBool("NoOrder", false))
+            results.order = site_average("Z", "Zdag");
+        if (!args.getBool("NoTransvOrder", false))
+            results.transv_order = site_average("X", "Xdag");
+        if (!args.getBool("NoHalfChainCorrelator", false))
+            results.correlator_half = std::abs(expect({{"Z", 1}, {"Zdag", size/2}}));
+        if (!args.getBool("NoCorrelator", false)) {
+            unsigned begin = size/4, end = 3*size/4;
+            Vector corr_values{};
+            for (auto pos : ut::range(begin+1, end))
+                corr_values.push_back(std::abs(expect({{"Z", begin}, {"Zdag", pos}})));
+            results.correlator = corr_values;
+        }
+        if (levels.size() > 1) {
+            Vector excited_energies{};
+            for (auto n : ut::range(1ul, levels.size()))
+                excited_energies.push_back(levels[n].first);
+            results.excited_energies = excited_energies;
+        }
+        if (with_response && args.getBool("LinearResponse", false)) {
+            ut::ScopedTimer scope("phase_response");
+            auto [c1, c2] = phase_derivatives(coupling, sector);
+            // dH|gs>
+            cl::EDVector perturbed(gs.size(), 0.0);
+            for (auto i : it::range1(size)) {
+                auto z = chain.product({{"Z", i}}, gs), zdag = chain.product({{"Zdag", i}}, gs);
+                for (auto a : ut::range(gs.size()))
+                    perturbed[a] += c1 * z[a] + std::conj(c1) * zdag[a];
+            }
+            auto x = chain.correction_vector(gs, gs_energy, perturbed);
+            results.phase_response  = cl::detail::dot(gs, perturbed).real();
+            results.phase_curvature = longitudinal(c2, gs, gs).real() + 2.0 * cl::detail::dot(perturbed, x).real();
+        }
+        return std::make_pair(results, chain.to_mps(gs, sites));
+    }
+
+    /// Handles of the columns of a results table, resolved once per scan
+    struct Columns {
+        Handle gs_energy;
+        optional<Handle> disorder, order, transv_order, corr_half;
+        optional<Handle> dE_dphase, d2E_dphase2;
+        optional<Handle> fidelity, fidelity_susc;
+        optional<Handle> peak_rss;
+        std::vector<Handle> excited, correlator;
+        std::vector<pair<string, Handle>> timing;   // profile path and column
+        optional<Handle> alloc_count, alloc_mb, alloc_largest_mb;
+        // columns depending only on a single point, i.e. all but the
+        // couplings, the fidelity, the memory usage, timings and allocations
+        std::vector<Handle> point;
+        std::vector<string> point_ids;
+    };
+
+    /// State of a scan in progress: results table and resources
+    /// shared by its points
+    struct Scan {
+        unsigned sector;
+        Table table;
+        Columns cols;
+        std::unique_ptr<cl::RowCheckpoint> checkpoint;
+        cl::AdjacentStates states;
+        std::unique_ptr<cl::MPSStore> store;
+        std::unique_ptr<cl::ResultCache> cache;
+        std::unique_ptr<ut::RowWriter> stream;
+        ut::ProfileSum profile{};
+    };
+
     /// Computing observables for each couplings for a given sector
     Table compute(unsigned sector) {
-        unsigned n_steps    = couplings.size(),
-                 step       = 0,
-                 corr_begin = size/4,
-                 corr_end   = 3*size/4;
-        auto results = new_table(corr_begin, corr_end);
+        unsigned n_steps = couplings.size(),
+                 step    = 0;
+        auto scan = begin_scan(sector);
+        auto plan = thread_plan();
+        auto budget = ut::MemoryBudget(args.getReal("MemoryBudget", 0.));
+        auto footprint = memory_estimate_mb();
         auto timer = ut::Timer().start();
 
         // DMRG calculation for each coupling
-        #pragma omp parallel for
+        #pragma omp parallel for num_threads(plan.workers)
         for (auto i : ut::range(n_steps)) {
             #pragma omp critical
             { print_progress(++step, n_steps); }
-            auto [obs, psi] = observables_at(couplings.at(i), sector);
-            fill_table_row(results, obs, i);
+            ut::ScopedThreadPlan applied(plan, ut::thread_id());
+            budget.acquire(footprint);
+            compute_row(*scan, i);
+            budget.release(footprint);
         }
+        auto results = finish_scan(*scan);
         std::cout << " Done!\n";
         std::cout << "   Elapsed time: " << timer.stop() << "\n";
+        if (args.getBool("Timing", false)) {
+            std::cout << "   Time per phase (and allocations, if counted), summed over the computed points:\n";
+            ut::print_profile(std::cout, scan->profile.total());
+        }
 
         return results;
     };
 
+    /// Split of the cores between the points computed concurrently and the
+    /// BLAS threads of each DMRG: "TaskThreads" and "BlasThreads" (0 for
+    /// the default from the chain length and bond dimension), "PinThreads"
+    /// to pin each worker to its own cores
+    ut::ThreadPlan thread_plan() const {
+        int blas = args.getInt("BlasThreads", 0);
+        if (blas <= 0)
+            blas = ut::default_blas_threads(size, cl::max_dim(sweeps));
+        return ut::make_thread_plan(
+                args.getInt("TaskThreads", 0), blas, args.getBool("PinThreads", false)
+            );
+    }
+
+    /// A priori estimate in MB of the memory of a single point: the ground
+    /// and excited states with their MPO environments (complex, bond
+    /// dimension chi, MPO bond dimension k) plus the two-site eigensolver
+    ///     16 chi^2 [(1 + n_excited) L (N + k) + (niter + 2) N^2 k]
+    /// plus, with "LinearResponse", the correction vector with its
+    /// environments of H, V|psi0> and psi0, 16 chi^2 L (N + 2k + 1).
+    /// The environments of the states are not counted if they are spilled
+    /// to disk, which only the two-site DMRG does: dmrg1, pdmrg and the
+    /// correction vector keep theirs in memory
+    double memory_estimate_mb() const {
+        double chi = cl::max_dim(sweeps);
+        double k = args.getBool("PBC", false) ? 8 : 4;
+        int single_from = args.getInt("SingleSiteFrom", 0);
+        bool in_memory = (single_from >= 1 && single_from <= sweeps.nsweep())
+            || args.getInt("ParallelSegments", 1) > 1
+            || args.getBool("LinearResponse", false);
+        bool spilled = !in_memory && args.defined("SpillDim") && args.getInt("SpillDim") <= chi;
+        int niter = 2;
+        for (auto sw : it::range1(sweeps.nsweep()))
+            niter = std::max(niter, sweeps.niter(sw));
+        unsigned n_levels = args.getBool("NoExcited", false) ? 0 : n_excited;
+        double response = args.getBool("LinearResponse", false) ? size * (N + 2*k + 1) : 0.0;
+        double bytes = 16.0 * chi * chi * (
+                double(1 + n_levels) * size * (N + (spilled ? 0 : k))
+              + double(niter + 2) * N * N * k
+              + response
+            );
+        return bytes / (1024.0 * 1024.0);
+    }
+
+    /// Start a scan of all the couplings for a given sector. The rows can be
+    /// computed in any order and from any thread with compute_row, and the
+    /// results are collected with finish_scan
+    std::unique_ptr<Scan> begin_scan(unsigned sector) {
+        unsigned n_steps = couplings.size();
+        auto table = new_table(size/4, 3*size/4);
+        auto cols = columns_of(table);
+        auto scan = std::unique_ptr<Scan>(new Scan{
+            sector,
+            std::move(table),
+            cols,
+            args.defined("Checkpoint")
+                ? std::make_unique<cl::RowCheckpoint>(
+                        args.getString("Checkpoint"),
+                        scan_signature(sector),
+                        cols.point_ids
+                    )
+                : nullptr,
+            cl::AdjacentStates(args.getBool("Fidelity", false) ? n_steps : 0),
+            args.defined("StorePath")
+                ? std::make_unique<cl::MPSStore>(args.getString("StorePath"), args)
+                : nullptr,
+            args.defined("CachePath")
+                ? std::make_unique<cl::ResultCache>(args.getString("CachePath"))
+                : nullptr,
+            args.defined("StreamFile")
+                ? std::make_unique<ut::RowWriter>(
+                        args.getString("StreamFile"),
+                        stream_columns(cols),
+                        args.getInt("StreamPrecision", 12)
+                    )
+                : nullptr
+        });
+        if (scan->checkpoint && scan->checkpoint->n_restored() > 0)
+            std::cout << "   Resuming " << scan->checkpoint->n_restored()
+                      << " rows from the checkpoint\n";
+        return scan;
+    }
+
+    /// Compute the i-th row of the results, or restore it from the cache
+    /// or the checkpoint. Returns whether the DMRG had to run.
+    /// With "CacheOnly" a point neither in the cache nor in the checkpoint
+    /// is an error
+    bool compute_row(Scan & scan, unsigned i) {
+        auto & table = scan.table;
+        auto & cols = scan.cols;
+        auto coupling = couplings.at(i);
+        auto with_fidelity = args.getBool("Fidelity", false);
+        auto hash = scan.cache ? point_hash(coupling, scan.sector) : string{};
+        auto cached = scan.cache ? scan.cache->load(hash) : std::nullopt;
+        auto restored = scan.checkpoint ? scan.checkpoint->restored(i) : std::nullopt;
+        if (!restored && !cached && args.getBool("CacheOnly", false))
+            throw std::runtime_error(
+                    "Point at coupling " + ut::exact_str(coupling) + " (L = " + str(size)
+                  + ", sector " + str(scan.sector) + ") missing from the result cache"
+                );
+
+        optional<it::MPS> state{};
+        if (restored) {
+            fill_point_row(table, cols, restored.value(), i);
+            if (with_fidelity)
+                state = stored_state(scan, coupling);
+        } else if (cached) {
+            fill_cached_row(table, cached.value(), i);
+            if (scan.checkpoint)
+                scan.checkpoint->save(i, point_row(table, cols, i));
+            // the state is needed only for the overlaps with the neighbours
+            if (with_fidelity)
+                state = stored_state(scan, coupling);
+        } else {
+            // peak of the whole process while the point runs, i.e.
+            // including the points running concurrently on other threads
+            auto sampler = cols.peak_rss ? std::make_unique<ut::RssSampler>() : nullptr;
+            auto [obs, psi] = timed_observables_at(coupling, scan.sector);
+            if (sampler)
+                table(cols.peak_rss.value(), i) = sampler->peak_mb();
+            auto profile = ut::take_profile();
+            for (const auto & [path, col] : cols.timing)
+                if (auto entry = profile.find(path); entry != profile.end())
+                    table(col, i) = entry->second.seconds;
+            if (cols.alloc_count) {
+                const auto & point = profile["point"];
+                table(cols.alloc_count.value(), i)      = point.allocations;
+                table(cols.alloc_mb.value(), i)         = point.bytes / 1048576.0;
+                table(cols.alloc_largest_mb.value(), i) = point.largest / 1048576.0;
+            }
+            scan.profile.add(profile);
+            fill_table_row(table, cols, obs, i);
+            if (scan.store)
+                scan.store->save(state_key(coupling, scan.sector), psi);
+            if (scan.cache)
+                scan.cache->save(hash, cached_row(table, cols, i));
+            if (scan.checkpoint)
+                scan.checkpoint->save(i, point_row(table, cols, i));
+            state = psi;
+        }
+
+        if (scan.stream) {
+            auto values = point_row(table, cols, i);
+            values.insert(values.begin(), coupling);
+            scan.stream->push(i, std::move(values));
+        }
+
+        if (with_fidelity)
+            fill_fidelity_rows(table, cols, scan.states.push(i, state));
+        return !restored && !cached;
+    }
+
+    /// Complete a scan, returning its results
+    Table finish_scan(Scan & scan) {
+        if (scan.stream)
+            scan.stream->finish();
+        return std::move(scan.table);
+    }
+
+    /// Hash of all the inputs determining the results at a coupling,
+    /// used as key for the result cache
+    string point_hash(double coupling, unsigned sector) {
+        std::ostringstream inputs;
+        inputs << cl::version << "\n"
+               << N << " " << size << " " << ut::exact_str(coupling) << " "
+               << sector << " " << n_excited << "\n"
+               << "PhaseNoise " << ut::exact_str(args.getReal("PhaseNoise", 0.)) << "\n";
+        for (auto flag : result_flags)
+            inputs << flag << " " << args.getBool(flag, false) << "\n";
+        if (uses_ed())
+            inputs << "ExactDiagonalization\n";
+        if (args.getInt("ParallelSegments", 1) > 1)
+            inputs << "ParallelSegments " << args.getInt("ParallelSegments") << "\n";
+        if (args.getInt("SingleSiteFrom", 0) > 0)
+            inputs << "SingleSiteFrom " << args.getInt("SingleSiteFrom") << " "
+                   << ut::exact_str(args.getReal("ExpansionAlpha", 1e-6)) << "\n";
+        if (args.getBool("LinearResponse", false))
+            inputs << "Response " << args.getInt("ResponseSweeps", 4) << " " << args.getInt("ResponseLocalIter", 10) << " "
+                   << args.getInt("ResponseMaxIter", 1000) << " " << ut::exact_str(args.getReal("ResponseTolerance", 1e-10)) << "\n";
+        inputs << cl::sweeps_table(sweeps);
+        return ut::to_hex(ut::fnv1a(inputs.str()));
+    }
+
 private:
+    /// Boolean options changing the results of a single point
+    static constexpr const char * result_flags[] = {
+        "PBC", "OnlyBulk", "LinearResponse",
+        "NoDisorder", "NoOrder", "NoTransvOrder", "NoHalfChainCorrelator",
+        "NoCorrelator", "NoExcited"
+    };
+
+    /// Phases of a point with a timing column "time_<phase>", in seconds
+    static constexpr const char * timed_phases[] = {
+        "hamiltonian", "ground_state", "excited_states", "phase_response", "exact_diagonalization",
+        "disorder", "order", "transv_order", "half_chain_correlator", "correlator"
+    };
+
+    /// observables_at in the "point" scope of the thread profile,
+    /// with its phases nested in it
+    pair<optional<Observables>, it::MPS>
+    timed_observables_at(double coupling, unsigned sector) {
+        ut::ScopedTimer scope("point");
+        return observables_at(coupling, sector);
+    }
+
+    /// Ground state saved in the MPS store by a previous run, if any
+    optional<it::MPS> stored_state(Scan & scan, double coupling) {
+        if (!scan.store)
+            return std::nullopt;
+        auto psi = scan.store->load(state_key(coupling, scan.sector));
+        // the stored state comes with the site indices of a different run
+        if (psi)
+            psi->replaceSiteInds(sites.inds());
+        return psi;
+    }
+
+    /// Resolve the handles of the columns of a results table
+    Columns columns_of(const Table & table) {
+        auto find = [&table](const string & id) -> optional<Handle> {
+            if (table.contains(id))
+                return table.handle(id);
+            return std::nullopt;
+        };
+
+        auto cols = Columns{table.handle("gs_energy")};
+        cols.disorder      = find("disorder");
+        cols.order         = find("order");
+        cols.transv_order  = find("transv_order");
+        cols.corr_half     = find("corr_half");
+        cols.dE_dphase     = find("dE_dphase");
+        cols.d2E_dphase2   = find("d2E_dphase2");
+        cols.fidelity      = find("fidelity");
+        cols.fidelity_susc = find("fidelity_susc");
+        cols.peak_rss      = find("peak_rss_mb");
+        for (auto n = 1u; table.contains("E" + str(n)); n++)
+            cols.excited.push_back(table.handle("E" + str(n)));
+        for (auto r = 1u; table.contains("corr_R_" + str(r)); r++)
+            cols.correlator.push_back(table.handle("corr_R_" + str(r)));
+
+        if (table.contains("time_point"))
+            cols.timing.emplace_back("point", table.handle("time_point"));
+        for (auto phase : timed_phases)
+            if (table.contains("time_" + string(phase)))
+                cols.timing.emplace_back("point/" + string(phase), table.handle("time_" + string(phase)));
+        cols.alloc_count      = find("alloc_count");
+        cols.alloc_mb         = find("alloc_mb");
+        cols.alloc_largest_mb = find("alloc_largest_mb");
+
+        for (const auto & id : table.ids()) {
+            if (id == "couplings" || id == "fidelity" || id == "fidelity_susc" || id == "peak_rss_mb")
+                continue;
+            if (id.rfind("time_", 0) == 0 || id.rfind("alloc_", 0) == 0)
+                continue;
+            cols.point.push_back(table.handle(id));
+            cols.point_ids.push_back(id);
+        }
+        return cols;
+    }
+
+    /// Values of the point columns of the i-th row
+    std::vector<double> point_row(const Table & table, const Columns & cols, unsigned row) {
+        std::vector<double> values{};
+        values.reserve(cols.point.size());
+        for (auto h : cols.point)
+            values.push_back(table(h, row));
+        return values;
+    }
+
+    /// Fill the point columns of the i-th row, in the order of cols.point
+    void fill_point_row(Table & table, const Columns & cols, const std::vector<double> & values, unsigned row) {
+        for (auto n : ut::range(cols.point.size()))
+            table(cols.point.at(n), row) = values.at(n);
+    }
+
+    /// Ids of the streamed columns: couplings and point columns
+    std::vector<string> stream_columns(const Columns & cols) {
+        auto ids = cols.point_ids;
+        ids.insert(ids.begin(), "couplings");
+        return ids;
+    }
+
+    /// Hash identifying a whole scan, to match a checkpoint with its scan
+    string scan_signature(unsigned sector) {
+        string hashes{};
+        for (auto coupling : couplings)
+            hashes += point_hash(coupling, sector);
+        return ut::to_hex(ut::fnv1a(hashes));
+    }
+
+    /// Results of the i-th row, for the result cache
+    cl::ResultCache::Row cached_row(const Table & table, const Columns & cols, unsigned row) {
+        cl::ResultCache::Row values{};
+        values.reserve(cols.point.size());
+        for (auto n : ut::range(cols.point.size()))
+            values.emplace_back(cols.point_ids.at(n), table(cols.point.at(n), row));
+        return values;
+    }
+
+    /// Fill the i-th row with the results restored from the cache
+    void fill_cached_row(Table & table, const cl::ResultCache::Row & values, unsigned row) {
+        for (const auto & [id, value] : values)
+            if (table.contains(id))
+                table(table.handle(id), row) = value;
+    }
+
     /// Create the Table object for storing the results of a single
     /// DMRG calculation
     Table new_table(unsigned corr_begin, unsigned corr_end) {
-        auto table = Table("couplings", couplings, "gs_energy", Array{});
+        auto schema = std::vector<string>{"couplings", "gs_energy"};
 
         // Optional columns
         const auto opts_cols = std::vector<pair<string, string>>{
@@ -241,56 +1078,108 @@ private:
         };
         for (auto opt_col : opts_cols) {
             if (!args.getBool(opt_col.first, false))
-                table.add_columns(opt_col.second, Array{});
+                schema.push_back(opt_col.second);
+        }
+
+        // Optional linear response columns
+        if (args.getBool("LinearResponse", false)) {
+            schema.push_back("dE_dphase");
+            schema.push_back("d2E_dphase2");
         }
 
         // Optional excited energies columns
         if (!args.getBool("NoExcited", false))
             for (auto n : ut::range(n_excited))
-                table.add_columns("E" + str(n+1), Array{});
+                schema.push_back("E" + str(n+1));
 
         // Optional correlator columns
         if (!args.getBool("NoCorrelator", false))
             for (auto r : ut::range(1u, corr_end - corr_begin))
-                table.add_columns("corr_R_" + str(r), Array{});
+                schema.push_back("corr_R_" + str(r));
+
+        auto table = Table(schema, couplings.size());
+        table["couplings"] = couplings;
+
+        // Optional fidelity columns, the last row has no neighbour
+        if (args.getBool("Fidelity", false))
+            table.add_columns(
+                    "fidelity",      Array(couplings.size(), std::nan("")),
+                    "fidelity_susc", Array(couplings.size(), std::nan(""))
+                );
+
+        // Optional memory usage column, empty for cached or restored points
+        if (args.getBool("TrackMemory", false))
+            table.add_columns("peak_rss_mb", Array(couplings.size(), std::nan("")));
+
+        // Optional timing columns, empty for cached or restored points
+        if (args.getBool("Timing", false)) {
+            table.add_columns("time_point", Array(couplings.size(), std::nan("")));
+            for (auto phase : timed_phases)
+                table.add_columns("time_" + string(phase), Array(couplings.size(), std::nan("")));
+        }
+
+        // Optional allocation columns of each point, if counted (see
+        // utils/allocation_hooks.h): number, MB and largest single one
+        if (args.getBool("Timing", false) && ut::allocations_counted())
+            table.add_columns(
+                    "alloc_count",      Array(couplings.size(), std::nan("")),
+                    "alloc_mb",         Array(couplings.size(), std::nan("")),
+                    "alloc_largest_mb", Array(couplings.size(), std::nan(""))
+                );
         return table;
     }
 
     /// Fill all the correlator entries of the given row
-    void fill_correlator_row(Table & table, const Vector & corr_values, unsigned row) {
+    void fill_correlator_row(Table & table, const Columns & cols, const Vector & corr_values, unsigned row) {
         for (auto r : ut::range(corr_values.size()))
-           table["corr_R_" + str(r+1)][row] = corr_values.at(r);
+           table(cols.correlator.at(r), row) = corr_values.at(r);
     }
 
     /// Fills all the excited energies entries of a given row
-    void fill_excited_row(Table & table, const Vector & excited_levels, unsigned row) {
-        for (auto n : ut::range(n_excited))
-            table["E" + str(n+1)][row] = excited_levels.at(n);
+    void fill_excited_row(Table & table, const Columns & cols, const Vector & excited_levels, unsigned row) {
+        for (auto n : ut::range(excited_levels.size()))
+            table(cols.excited.at(n), row) = excited_levels.at(n);
+    }
+
+    /// Fill the fidelity entries of the pairs (i, i+1), stored in the i-th row
+    void fill_fidelity_rows(
+        Table & table,
+        const Columns & cols,
+        const std::vector<cl::AdjacentStates::Overlap> & overlaps
+    ) {
+        for (auto [row, fid] : overlaps) {
+            table(cols.fidelity.value(), row) = fid;
+            table(cols.fidelity_susc.value(), row) = cl::fidelity_susceptibility(
+                    fid, couplings.at(row+1) - couplings.at(row), size
+                );
+        }
     }
 
     /// Fill all the entries of a row with the given observables
-    void fill_table_row(Table & table, const optional<Observables> & obs, unsigned row) {
+    void fill_table_row(Table & table, const Columns & cols, const optional<Observables> & obs, unsigned row) {
         if (!obs)
             return;
 
         auto& obs_val = obs.value();
-        table["gs_energy"][row] = obs_val.gs_energy;
+        table(cols.gs_energy, row) = obs_val.gs_energy;
 
-        const auto opt_values = std::vector<pair<string, optional<double>>>{
-            {"disorder",     obs_val.disorder},
-            {"order",        obs_val.order},
-            {"transv_order", obs_val.transv_order},
-            {"corr_half",    obs_val.correlator_half},
-        };
-        for (auto opt_val : opt_values) {
-            if (opt_val.second)
-                table[opt_val.first][row] = opt_val.second.value();
+        const auto opt_values = std::array<pair<optional<Handle>, optional<double>>, 6>{{
+            {cols.disorder,     obs_val.disorder},
+            {cols.order,        obs_val.order},
+            {cols.transv_order, obs_val.transv_order},
+            {cols.corr_half,    obs_val.correlator_half},
+            {cols.dE_dphase,    obs_val.phase_response},
+            {cols.d2E_dphase2,  obs_val.phase_curvature},
+        }};
+        for (const auto & [col, value] : opt_values) {
+            if (col && value)
+                table(col.value(), row) = value.value();
         }
 
         if (obs_val.excited_energies)
-            fill_excited_row(table, obs_val.excited_energies.value(), row);
+            fill_excited_row(table, cols, obs_val.excited_energies.value(), row);
         if (obs_val.correlator)
-            fill_correlator_row(table, obs_val.correlator.value(), row);
+            fill_correlator_row(table, cols, obs_val.correlator.value(), row);
     }
 
     /// Simply print the progress
@@ -0,0 +1,58 @@
+#ifndef __CLOCK_SITEOPS_H
+#define __CLOCK_SITEOPS_H
+
+#include <array>
+#include <vector>
+#include <stdexcept>
+
+#include "itensor/all.h"
+#include "clock.h"
+#include "types.h"
+
+/************************************************************/
+namespace clocks {
+
+///
+/// Operators "X", "Xdag", "Z", "Zdag" of every site, built once for a
+/// site set and shared read-only by the measurements of all the states,
+/// distances and threads, instead of building a new tensor at each step
+///
+template<unsigned N>
+class SiteOps {
+    static constexpr std::array<const char *, 4> names = {"X", "Xdag", "Z", "Zdag"};
+    std::array<std::vector<it::ITensor>, 4> tensors;    // by name, then site from 1
+
+public:
+    explicit SiteOps(const Clock<N> & sites);
+
+    int length() const { return int(tensors.front().size()) - 1; }
+
+    /// Operator opname at site i
+    const it::ITensor & operator()(const string & opname, int i) const;
+};
+
+/************************************************************/
+
+template<unsigned N>
+SiteOps<N>::SiteOps(const Clock<N> & sites) {
+    int L = it::length(sites);
+    for (auto n : it::range(names.size())) {
+        tensors[n].reserve(L + 1);
+        tensors[n].emplace_back();
+        for (auto i : it::range1(L))
+            tensors[n].push_back(op(sites, names[n], i));
+    }
+}
+
+template<unsigned N>
+const it::ITensor &
+SiteOps<N>::operator()(const string & opname, int i) const {
+    for (auto n : it::range(names.size()))
+        if (opname == names[n])
+            return tensors[n].at(i);
+    throw std::runtime_error("Unrecognized operator \"" + opname + "\"");
+}
+
+}
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef __CLOCK_STORE_H
+#define __CLOCK_STORE_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <istream>
+#include <optional>
+#include <stdexcept>
+#include <filesystem>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+
+#include "itensor/all.h"
+#include "clock.h"
+#include "../utils/hash.h"
+#include "../utils/mmap.h"
+
+/************************************************************/
+namespace clocks {
+
+///
+/// Key identifying a stored ground state: the point in readable form and
+/// the hash of all the inputs of the calculation, which tells apart the
+/// Hamiltonians (boundary conditions, phase noise, ...) and the solvers
+///
+struct StateKey {
+    unsigned N;
+    unsigned length;
+    double   coupling;
+    unsigned sector;
+    string   inputs;        // see ComputeObservables::point_hash
+
+    /// Textual form, as written in the index
+    string str() const {
+        return std::to_string(N) + " " + std::to_string(length) + " "
+             + utils::exact_str(coupling) + " " + std::to_string(sector) + " "
+             + inputs;
+    }
+};
+
+///
+/// On-disk archive of MPS, one binary file per state plus an index file
+/// with a line "<key> <filename>" for each state. The index is appended
+/// under an exclusive flock, so that several processes can share a store.
+///
+/// States are read back through a memory mapping of the file, so the
+/// loading does not go through any intermediate stream buffer.
+/// Optionally, with "CompressCutoff", the singular values below the
+/// cutoff are dropped before writing (lossy).
+///
+class MPSStore {
+public:
+    struct Entry {
+        StateKey key;
+        string   filename;
+    };
+
+private:
+    std::filesystem::path dir;
+    std::map<string, Entry> entries_;
+    double compress_cutoff;
+    mutable std::mutex mtx;
+
+public:
+    MPSStore(const string & directory, const it::Args & args = it::Args::global());
+
+    /// Save a state, replacing any previous one with the same key
+    void save(const StateKey & key, it::MPS psi);
+
+    /// Load a state, if present
+    std::optional<it::MPS> load(const StateKey & key) const;
+
+    bool contains(const StateKey & key) const;
+    std::vector<Entry> entries() const;
+
+    /// Call func(entry, sites, psi) on every stored state of clock order N,
+    /// in parallel. The sites are rebuilt from the site indices of psi
+    template<unsigned N, typename Func>
+    void for_each(Func func) const;
+
+private:
+    std::optional<it::MPS> read_state(const string & filename) const;
+    void read_index();
+};
+
+/************************************************************/
+
+inline MPSStore::MPSStore(const string & directory, const it::Args & args) :
+    dir(directory),
+    compress_cutoff(args.getReal("CompressCutoff", 0.0))
+{
+    std::filesystem::create_directories(dir);
+    read_index();
+}
+
+inline void
+MPSStore::read_index() {
+    std::ifstream index{dir / "index.txt"};
+    string line;
+    while (std::getline(index, line)) {
+        std::istringstream fields{line};
+        Entry entry;
+        auto & key = entry.key;
+        string extra;
+        // lines in any other format, e.g. from older versions, are skipped
+        if (fields >> key.N >> key.length >> key.coupling >> key.sector
+                   >> key.inputs >> entry.filename && !(fields >> extra))
+            entries_[key.str()] = entry;
+    }
+}
+
+inline void
+MPSStore::save(const StateKey & key, it::MPS psi) {
+    if (compress_cutoff > 0.0)
+        psi.orthogonalize({"Cutoff", compress_cutoff});
+
+    auto filename = "psi_" + utils::to_hex(utils::fnv1a(key.str())) + ".mps";
+    it::writeToFile((dir / filename).string(), psi);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    auto path = (dir / "index.txt").string();
+    int fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open index '" + path + "': " + std::strerror(errno));
+    if (::flock(fd, LOCK_EX) != 0) {
+        auto error = errno;
+        ::close(fd);
+        throw std::runtime_error("Cannot lock index '" + path + "': " + std::strerror(error));
+    }
+    auto line = key.str() + " " + filename + "\n";
+    auto written = ::write(fd, line.data(), line.size());
+    auto error = errno;
+    ::close(fd);
+    if (written != ssize_t(line.size()))
+        throw std::runtime_error("Cannot write index '" + path + "': " + std::strerror(error));
+    entries_[key.str()] = Entry{key, filename};
+}
+
+inline std::optional<it::MPS>
+MPSStore::read_state(const string & filename) const {
+    auto path = (dir / filename).string();
+    if (!std::filesystem::exists(path))
+        return std::nullopt;
+    auto mapped = utils::MappedFile(path);
+    auto buffer = utils::memory_buf(mapped.data(), mapped.size());
+    std::istream stream(&buffer);
+    auto psi = it::MPS{};
+    it::read(stream, psi);
+    return psi;
+}
+
+inline std::optional<it::MPS>
+MPSStore::load(const StateKey & key) const {
+    string filename;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto entry = entries_.find(key.str());
+        if (entry == entries_.end())
+            return std::nullopt;
+        filename = entry->second.filename;
+    }
+    return read_state(filename);
+}
+
+inline bool
+MPSStore::contains(const StateKey & key) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return entries_.count(key.str()) > 0;
+}
+
+inline std::vector<MPSStore::Entry>
+MPSStore::entries() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::vector<Entry> list{};
+    list.reserve(entries_.size());
+    for (const auto & item : entries_)
+        list.push_back(item.second);
+    return list;
+}
+
+template<unsigned N, typename Func>
+void
+MPSStore::for_each(Func func) const {
+    std::vector<Entry> list{};
+    for (const auto & entry : entries())
+        if (entry.key.N == N)
+            list.push_back(entry);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (std::size_t i = 0; i < list.size(); i++) {
+        auto psi = read_state(list[i].filename);
+        if (!psi)
+            continue;
+        auto sites = Clock<N>(it::siteInds(psi.value()));
+        func(list[i], sites, psi.value());
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef __CLOCK_SWEEPS_H
+#define __CLOCK_SWEEPS_H
+
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+
+#include "itensor/all.h"
+#include "types.h"
+#include "../utils/hash.h"
+
+/************************************************************/
+namespace clocks {
+
+/// Text representation of a sweep schedule, one line per sweep
+/// with maxdim, mindim, cutoff, niter and noise
+inline string sweeps_table(const it::Sweeps & sweeps);
+
+/// Hash identifying a sweep schedule
+inline string sweeps_hash(const it::Sweeps & sweeps);
+
+/// Sweep schedule made of the sweeps first, ..., last of the given one
+/// (counting from 1, last = 0 means up to the end)
+inline it::Sweeps sweeps_range(const it::Sweeps & sweeps, int first, int last = 0);
+
+/// Largest bond dimension of a sweep schedule
+inline int max_dim(const it::Sweeps & sweeps);
+
+/// Truncation and eigensolver options of the sw-th sweep,
+/// for the solvers sweeping by hand
+inline it::Args sweep_args(const it::Sweeps & sweeps, int sw);
+
+/************************************************************/
+
+inline string sweeps_table(const it::Sweeps & sweeps) {
+    string table{};
+    for (auto sw : it::range1(sweeps.nsweep())) {
+        table += std::to_string(sweeps.maxdim(sw)) + " "
+               + std::to_string(sweeps.mindim(sw)) + " "
+               + utils::exact_str(sweeps.cutoff(sw)) + " "
+               + std::to_string(sweeps.niter(sw))  + " "
+               + utils::exact_str(sweeps.noise(sw)) + "\n";
+    }
+    return table;
+}
+
+inline string sweeps_hash(const it::Sweeps & sweeps) {
+    return utils::to_hex(utils::fnv1a(sweeps_table(sweeps)));
+}
+
+inline it::Sweeps sweeps_range(const it::Sweeps & sweeps, int first, int last) {
+    if (last == 0)
+        last = sweeps.nsweep();
+    if (first < 1 || last > sweeps.nsweep() || first > last)
+        throw std::invalid_argument("Invalid range of sweeps");
+
+    auto range = it::Sweeps(last - first + 1);
+    for (auto sw : it::range1(range.nsweep())) {
+        range.setmaxdim(sw, sweeps.maxdim(first + sw - 1));
+        range.setmindim(sw, sweeps.mindim(first + sw - 1));
+        range.setcutoff(sw, sweeps.cutoff(first + sw - 1));
+        range.setniter(sw,  sweeps.niter(first + sw - 1));
+        range.setnoise(sw,  sweeps.noise(first + sw - 1));
+    }
+    return range;
+}
+
+inline int max_dim(const it::Sweeps & sweeps) {
+    int maxdim = 0;
+    for (auto sw : it::range1(sweeps.nsweep()))
+        maxdim = std::max(maxdim, sweeps.maxdim(sw));
+    return maxdim;
+}
+
+inline it::Args sweep_args(const it::Sweeps & sweeps, int sw) {
+    return it::Args{
+        "MaxDim",  sweeps.maxdim(sw),
+        "MinDim",  sweeps.mindim(sw),
+        "Cutoff",  sweeps.cutoff(sw),
+        "MaxIter", sweeps.niter(sw),
+        "Noise",   sweeps.noise(sw)
+    };
+}
+
+}
+
+#endif
@@ -5,6 +5,10 @@
 #include "../utils/all.h"
 
 namespace clocks {
+    // Bump when a change alters the results of the simulations,
+    // it invalidates the cached results
+    inline constexpr const char * version = "0.2.0";
+
     namespace it = itensor;
     using complex = std::complex<double>;
     using std::string;
@@ -29,24 +29,28 @@ constexpr int mod1(int i, int n) {
 
 // Primes one index
 template<typename T>
-it::ITensor prime_inds(it::ITensor psi, T ind) {
+it::ITensor prime_inds(const it::ITensor & psi, const T & ind) {
     return it::prime(psi, ind);
 }
 
-// Shorthand for priming multiple indices at once
+// Shorthand for priming multiple indices at once,
+// with a single copy of the tensor
 template<typename T, typename... Args>
 it::ITensor
-prime_inds(it::ITensor psi, T ind, Args... args) {
-    return prime_inds(it::prime(psi, ind), args...);
+prime_inds(const it::ITensor & psi, const T & ind, const Args &... args) {
+    auto primed = it::prime(psi, ind);
+    (primed.prime(args), ...);
+    return primed;
 }
 
 // Convert unordered_map to vector
 template<typename T1, typename T2>
 std::vector<T2>
-umap_to_vector(std::unordered_map<T1, T2> in, std::vector<T1> keys) {
+umap_to_vector(const std::unordered_map<T1, T2> & in, const std::vector<T1> & keys) {
     std::vector<T2> out;
-    for (auto k : keys)
-        out.push_back(in[k]);
+    out.reserve(keys.size());
+    for (const auto & k : keys)
+        out.push_back(in.at(k));
     return out;
 }
 
@@ -64,6 +68,33 @@ umap_to_vector(std::unordered_map<T1, T2> in, std::vector<T1> keys) {
 // Timers
 #include "timer.h"
 
+// Allocation counters
+#include "allocations.h"
+
+// Hierarchical scoped timers
+#include "profile.h"
+
+// Stable hashes
+#include "hash.h"
+
+// Memory mapped files
+#include "mmap.h"
+
+// Columnar binary tables
+#include "binary.h"
+
+// Asynchronous streaming of table rows
+#include "writer.h"
+
+// Task and BLAS threads, core pinning
+#include "threads.h"
+
+// Memory usage and budget
+#include "memory.h"
+
+// Streaming mean and variance
+#include "stats.h"
+
 /************************************************************/
 
 
@@ -0,0 +1,52 @@
+#ifndef __CLOCK_UTILS_ALLOCATION_HOOKS_H
+#define __CLOCK_UTILS_ALLOCATION_HOOKS_H
+
+// Replacement of the global operator new and delete counting the heap
+// allocations of each thread, see allocations.h.
+// The replacement functions cannot be inline: include this header in a
+// single translation unit of the program, e.g. the one with main, only
+// when the allocations have to be counted (COUNT_ALLOCATIONS=1 with make)
+
+#include <new>
+#include <cstdlib>
+
+#include "allocations.h"
+
+namespace utils::detail {
+    inline void * counted_malloc(std::size_t bytes) {
+        count_allocation(bytes);
+        return std::malloc(bytes > 0 ? bytes : 1);
+    }
+
+    // Enables the counting before main
+    static const bool allocation_hooks_installed = (allocations_counted() = true);
+}
+
+void * operator new(std::size_t bytes) {
+    if (auto ptr = utils::detail::counted_malloc(bytes))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void * operator new[](std::size_t bytes) {
+    if (auto ptr = utils::detail::counted_malloc(bytes))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void * operator new(std::size_t bytes, const std::nothrow_t &) noexcept {
+    return utils::detail::counted_malloc(bytes);
+}
+
+void * operator new[](std::size_t bytes, const std::nothrow_t &) noexcept {
+    return utils::detail::counted_malloc(bytes);
+}
+
+void operator delete(void * ptr) noexcept { std::free(ptr); }
+void operator delete[](void * ptr) noexcept { std::free(ptr); }
+void operator delete(void * ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void * ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void * ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete[](void * ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+
+#endif
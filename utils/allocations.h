@@ -0,0 +1,51 @@
+#ifndef __CLOCK_UTILS_ALLOCATIONS_H
+#define __CLOCK_UTILS_ALLOCATIONS_H
+
+#include <cstddef>
+#include <algorithm>
+
+/************************************************************/
+namespace utils {
+
+// Heap allocations made by a thread: number, bytes and largest single
+// allocation (for the tensors, the largest storage)
+struct AllocationStats {
+    unsigned long count = 0;
+    unsigned long bytes = 0;
+    std::size_t largest = 0;
+};
+
+// Allocations counted so far on the current thread. They are counted
+// only in programs with the replacement operator new of
+// allocation_hooks.h, otherwise they stay zero
+inline AllocationStats & thread_allocations();
+
+// Whether the allocations are counted in this program
+inline bool & allocations_counted();
+
+// Count an allocation of the given size on the current thread
+inline void count_allocation(std::size_t bytes);
+
+/************************************************************/
+
+inline AllocationStats & thread_allocations() {
+    // trivial type: no initialization guard, safe inside operator new
+    static thread_local AllocationStats stats;
+    return stats;
+}
+
+inline bool & allocations_counted() {
+    static bool counted = false;
+    return counted;
+}
+
+inline void count_allocation(std::size_t bytes) {
+    auto & stats = thread_allocations();
+    stats.count++;
+    stats.bytes += bytes;
+    stats.largest = std::max(stats.largest, bytes);
+}
+
+}
+
+#endif
@@ -2,12 +2,20 @@
 #define __CLOCK_UTILS_BENCHMARK
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <chrono>
 #include <functional>
 #include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
 #include <utility>
 
 #include "time.h"
+#include "format.h"
 
 /************************************************************/
 namespace utils {
@@ -15,75 +23,150 @@ namespace utils {
 using func_t = std::function<void()>;
 
 // benchmark class
-// it is initialized with a void function func_t, the object to benchmark
-template<unsigned N_iter = 1> class Benchmark;
-
-
-
-template<unsigned N_iter>
+// it is initialized with a name and a void function func_t, the object
+// to benchmark, which is run first for the warm-up iterations (timed but
+// excluded from the statistics) and then for the measured ones
 class Benchmark {
 private:
     using clock = chrono::steady_clock;
-    using time_point = chrono::time_point<clock>;
-    std::array<time_point, N_iter+1> time_points;
-    func_t func;
+    std::string name_;
+    std::vector<double> warmup_laps{};  // seconds
+    std::vector<double> laps{};         // seconds
 
 public:
-    Benchmark(const func_t & func_) {
-        func = func_;
-        time_points.front() = clock::now();
-        for (unsigned i=0; i<N_iter; i++) {
+    Benchmark(const std::string & name, const func_t & func, unsigned iterations = 10, unsigned warmup = 1);
+
+    const std::string & name() const { return name_; }
+    unsigned iterations() const { return laps.size(); }
+
+    // statistics of the measured laps, in seconds
+    double total() const;
+    double mean() const;
+    double median() const { return percentile(50.0); }
+    double percentile(double p) const;
+    double stddev() const;      // sample standard deviation
+    double warmup() const;      // total of the warm-up laps
+
+    void print_statistics() const;
+
+    // one line JSON object
+    std::string json() const;
+};
+
+// Write the benchmarks as a JSON array, one benchmark per line
+inline void write_json(const std::string & filename, const std::vector<Benchmark> & benchmarks);
+
+// Medians by benchmark name from a file written by write_json
+inline std::map<std::string, double> read_medians(const std::string & filename);
+
+/************************************************************/
+
+inline
+Benchmark::Benchmark(const std::string & name, const func_t & func, unsigned iterations, unsigned warmup) :
+    name_(name)
+{
+    auto run = [&func](std::vector<double> & times, unsigned n) {
+        times.reserve(n);
+        for (unsigned i = 0; i < n; i++) {
+            auto begin = clock::now();
             func();
-            time_points.at(i+1) = clock::now();
+            times.push_back(chrono::duration<double>(clock::now() - begin).count());
         }
     };
+    run(warmup_laps, warmup);
+    run(laps, std::max(iterations, 1u));
+}
 
-    // total duration
-    template<typename Time_t, typename Rep = long>
-    auto total_duration() {
-        return chrono::duration_cast<Time_t, Rep>(time_points.back() - time_points.front()).count();
-    };
+inline double
+Benchmark::total() const {
+    return std::accumulate(laps.begin(), laps.end(), 0.0);
+}
 
-    // single lap duration
-    template<typename Time_t, typename Rep = long>
-    auto duration(unsigned i) {
-        return chrono::duration_cast<Time_t, Rep>(time_points.at(i+1) - time_points.at(i)).count();
-    };
+inline double
+Benchmark::mean() const {
+    return total() / laps.size();
+}
 
-    // average duration
-    // std deviation of durations
-    template<typename Time_t, typename Rep = long>
-    auto average() {
-        std::array<Rep, N_iter> lap_times;
-        for (unsigned i=0; i < N_iter; i++) {
-            lap_times.at(i) = duration<Time_t, Rep>(i);
-        }
+inline double
+Benchmark::percentile(double p) const {
+    // linear interpolation between the closest ranks
+    auto sorted = laps;
+    std::sort(sorted.begin(), sorted.end());
+    double rank = p / 100.0 * (sorted.size() - 1);
+    auto lower = std::size_t(std::floor(rank));
+    auto upper = std::min(lower + 1, sorted.size() - 1);
+    return sorted[lower] + (rank - lower) * (sorted[upper] - sorted[lower]);
+}
+
+inline double
+Benchmark::stddev() const {
+    if (laps.size() < 2)
+        return 0.0;
+    auto avg = mean();
+    auto sum = std::accumulate(laps.begin(), laps.end(), 0.0,
+            [avg](double acc, double t){ return acc + (t - avg) * (t - avg); });
+    return std::sqrt(sum / (laps.size() - 1));
+}
+
+inline double
+Benchmark::warmup() const {
+    return std::accumulate(warmup_laps.begin(), warmup_laps.end(), 0.0);
+}
 
-        // Compute average
-        Rep avg = std::accumulate(
-                lap_times.begin(), lap_times.end(), Rep(0)
-            ) / lap_times.size();
-
-        // Compute std deviation
-        Rep dev = std::accumulate(
-                lap_times.begin(), lap_times.end(), Rep(0),
-                [&avg](Rep sum, Rep elem){ return sum + (avg - elem)*(avg - elem); }
-            );
-        dev = sqrt(dev);
-        return std::make_pair(avg, dev);
+inline void
+Benchmark::print_statistics() const {
+    std::cout
+        << "\t" << name_ << "\n"
+        << "\tNumber of iterations: " << iterations() << " (+" << warmup_laps.size() << " warm-up)\n"
+        << "\tTotal duration: " << total() << " s\n"
+        << "\tAverage duration: (" << mean() << " ± " << stddev() << ") s\n"
+        << "\tMedian duration: " << median() << " s, p90: " << percentile(90.0) << " s\n";
+}
+
+inline std::string
+Benchmark::json() const {
+    std::string line = "{\"name\": \"" + name_ + "\"";
+    auto field = [&line](const std::string & key, double value) {
+        line += ", \"" + key + "\": ";
+        append_number(line, value, 6);
     };
+    line += ", \"iterations\": " + std::to_string(iterations());
+    field("warmup_s", warmup());
+    field("mean_s",   mean());
+    field("median_s", median());
+    field("p90_s",    percentile(90.0));
+    field("stddev_s", stddev());
+    field("min_s",    *std::min_element(laps.begin(), laps.end()));
+    return line + "}";
+}
 
-    template<typename Time_t, typename Rep = long>
-    void print_statistics() {
-        auto total = total_duration<Time_t, Rep>();
-        auto [avg, dev] = average<Time_t, Rep>();
-        auto unit = units<Time_t>();
-        std::cout
-            << "\tNumber of iterations: " << N_iter << "\n"
-            << "\tTotal duration: " << total << " " << unit << "\n"
-            << "\tAverage duration: (" << avg << " ± " << dev << ") " << unit << "\n";
+inline void
+write_json(const std::string & filename, const std::vector<Benchmark> & benchmarks) {
+    std::ofstream file{filename};
+    file << "[\n";
+    for (std::size_t n = 0; n < benchmarks.size(); n++)
+        file << "  " << benchmarks[n].json() << (n + 1 < benchmarks.size() ? ",\n" : "\n");
+    file << "]\n";
+}
+
+inline std::map<std::string, double>
+read_medians(const std::string & filename) {
+    // only for the format of write_json, one object per line
+    std::map<std::string, double> medians{};
+    std::ifstream file{filename};
+    std::string line;
+    const std::string name_key = "\"name\": \"", median_key = "\"median_s\": ";
+    while (std::getline(file, line)) {
+        auto name_pos = line.find(name_key);
+        auto median_pos = line.find(median_key);
+        if (name_pos == std::string::npos || median_pos == std::string::npos)
+            continue;
+        name_pos += name_key.size();
+        auto name = line.substr(name_pos, line.find('"', name_pos) - name_pos);
+        medians[name] = std::stod(line.substr(median_pos + median_key.size()));
     }
-};
+    return medians;
+}
 
 }
 #endif
@@ -0,0 +1,167 @@
+#ifndef __CLOCK_UTILS_BINARY_H
+#define __CLOCK_UTILS_BINARY_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "mmap.h"
+
+/************************************************************/
+// Columnar binary tables
+//
+// Layout of the file (native endianness):
+//      "CLKTABLE"                  8 bytes magic
+//      version, ncols              2 x uint32
+//      nrows                       uint64
+//      for each column:
+//          name length, name       uint32 + chars
+//      zero padding up to a multiple of 8 bytes
+//      ncols x nrows doubles, one column after the other
+//
+// Doubles are stored bit by bit, so the round trip is exact.
+/************************************************************/
+
+namespace utils {
+
+namespace binary {
+    constexpr char magic[8] = {'C', 'L', 'K', 'T', 'A', 'B', 'L', 'E'};
+    constexpr std::uint32_t version = 1;
+}
+
+// Contiguous read-only view over a column
+class ColumnView {
+    const double * data_ = nullptr;
+    std::size_t size_ = 0;
+
+public:
+    ColumnView() = default;
+    ColumnView(const double * data, std::size_t size) : data_(data), size_(size) {}
+
+    const double * data()  const { return data_; }
+    std::size_t    size()  const { return size_; }
+    const double * begin() const { return data_; }
+    const double * end()   const { return data_ + size_; }
+    double operator[](std::size_t n) const { return data_[n]; }
+    double at(std::size_t n) const {
+        if (n >= size_)
+            throw std::out_of_range("Row out of range");
+        return data_[n];
+    }
+};
+
+// Write the given columns (all of nrows elements) as a binary table
+inline void write_binary(
+    std::string_view filename,
+    const std::vector<std::string> & ids,
+    const std::vector<const double *> & columns,
+    std::uint64_t nrows
+);
+
+// Binary table mapped in memory, the columns are views on the mapping
+class MappedTable {
+    MappedFile file;
+    std::vector<std::string> column_ids{};
+    std::unordered_map<std::string, ColumnView> columns{};
+    std::uint64_t nrows_ = 0;
+
+public:
+    explicit MappedTable(const std::string & filename);
+
+    const ColumnView & operator[](const std::string & id) const { return columns.at(id); }
+    const ColumnView & at(const std::string & id) const { return columns.at(id); }
+    bool contains(const std::string & id) const { return columns.count(id) > 0; }
+
+    unsigned ncols() const { return column_ids.size(); }
+    std::size_t nrows() const { return nrows_; }
+    const std::vector<std::string> & ids() const { return column_ids; }
+};
+
+/************************************************************/
+
+inline void
+write_binary(
+    std::string_view filename,
+    const std::vector<std::string> & ids,
+    const std::vector<const double *> & columns,
+    std::uint64_t nrows
+) {
+    if (ids.size() != columns.size())
+        throw std::invalid_argument("Number of ids and columns do not match");
+
+    std::ofstream file{std::string(filename), std::ios::binary | std::ios::trunc};
+    std::uint32_t ncols = ids.size();
+    file.write(binary::magic, sizeof(binary::magic));
+    file.write(reinterpret_cast<const char *>(&binary::version), sizeof(binary::version));
+    file.write(reinterpret_cast<const char *>(&ncols), sizeof(ncols));
+    file.write(reinterpret_cast<const char *>(&nrows), sizeof(nrows));
+
+    std::size_t offset = sizeof(binary::magic) + 2*sizeof(std::uint32_t) + sizeof(nrows);
+    for (const auto & id : ids) {
+        std::uint32_t len = id.size();
+        file.write(reinterpret_cast<const char *>(&len), sizeof(len));
+        file.write(id.data(), len);
+        offset += sizeof(len) + len;
+    }
+
+    // Align the data on 8 bytes, so the mapped columns are proper double arrays
+    const char zeros[8] = {};
+    file.write(zeros, (8 - offset % 8) % 8);
+
+    for (auto col : columns)
+        file.write(reinterpret_cast<const char *>(col), nrows * sizeof(double));
+    if (!file)
+        throw std::runtime_error("Error while writing '" + std::string(filename) + "'");
+}
+
+
+inline
+MappedTable::MappedTable(const std::string & filename) : file(filename) {
+    auto data = file.data();
+    auto size = file.size();
+    std::size_t offset = 0;
+
+    auto read = [&](void * dest, std::size_t n) {
+        if (offset + n > size)
+            throw std::runtime_error("Truncated binary table '" + filename + "'");
+        std::memcpy(dest, data + offset, n);
+        offset += n;
+    };
+
+    char magic[8];
+    std::uint32_t version, ncols;
+    read(magic, sizeof(magic));
+    if (std::memcmp(magic, binary::magic, sizeof(magic)) != 0)
+        throw std::runtime_error("'" + filename + "' is not a binary table");
+    read(&version, sizeof(version));
+    if (version != binary::version)
+        throw std::runtime_error("Unsupported version of binary table '" + filename + "'");
+    read(&ncols, sizeof(ncols));
+    read(&nrows_, sizeof(nrows_));
+
+    for (std::uint32_t c = 0; c < ncols; c++) {
+        std::uint32_t len;
+        read(&len, sizeof(len));
+        if (offset + len > size)
+            throw std::runtime_error("Truncated binary table '" + filename + "'");
+        column_ids.emplace_back(data + offset, len);
+        offset += len;
+    }
+    offset += (8 - offset % 8) % 8;
+
+    if (offset + ncols * nrows_ * sizeof(double) > size)
+        throw std::runtime_error("Truncated binary table '" + filename + "'");
+    auto values = reinterpret_cast<const double *>(data + offset);
+    for (std::uint32_t c = 0; c < ncols; c++)
+        columns.emplace(column_ids[c], ColumnView(values + c * nrows_, nrows_));
+}
+
+}
+
+#endif
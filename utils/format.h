@@ -0,0 +1,20 @@
+#ifndef __CLOCK_UTILS_FORMAT_H
+#define __CLOCK_UTILS_FORMAT_H
+
+#include <cstdio>
+#include <string>
+
+/************************************************************/
+namespace utils {
+
+// Append a number to a string, formatted as an ostream would do with
+// std::setprecision(precision), without going through a stream
+inline void append_number(std::string & line, double value, unsigned precision) {
+    char buffer[32];
+    auto n = std::snprintf(buffer, sizeof(buffer), "%.*g", int(precision), value);
+    line.append(buffer, n);
+}
+
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef __CLOCK_UTILS_HASH_H
+#define __CLOCK_UTILS_HASH_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+/************************************************************/
+namespace utils {
+
+// 64-bit FNV-1a hash, stable across runs and platforms
+// (unlike std::hash), usable as a key for files on disk
+constexpr std::uint64_t fnv1a(
+    std::string_view data,
+    std::uint64_t hash = 14695981039346656037ull
+) {
+    for (auto c : data) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Fixed width hexadecimal representation of a hash
+inline std::string to_hex(std::uint64_t hash) {
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash));
+    return std::string(buffer);
+}
+
+// Decimal representation with 17 significant digits, enough to read back
+// the same double (not the shortest one, e.g. 0.1 is 0.10000000000000001);
+// nan and inf are written as "nan" and "inf"
+inline std::string exact_str(double x) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.17g", x);
+    return std::string(buffer);
+}
+
+}
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef __CLOCK_UTILS_MEMORY_H
+#define __CLOCK_UTILS_MEMORY_H
+
+#include <string>
+#include <fstream>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <condition_variable>
+
+/************************************************************/
+namespace utils {
+
+// Resident set size of the process in MB, from /proc/self/status
+// (0 if not available)
+inline double rss_mb();
+
+// Peak resident set size of the process in MB, since the start
+// or the last reset_peak_rss()
+inline double peak_rss_mb();
+
+// Reset the peak resident set size to the current one,
+// returns false if the kernel does not support it.
+// The peak is the one of the whole process: not to be reset while
+// other threads measure it, see RssSampler
+inline bool reset_peak_rss();
+
+// Peak resident set size of the process in MB during the lifetime of the
+// sampler, from a background thread reading rss_mb() every period.
+// Unlike peak_rss_mb() it needs no reset, so that concurrent tasks can
+// each measure their own window; peaks shorter than the period are missed
+class RssSampler {
+    double peak;
+    bool stop = false;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::thread sampler;
+
+public:
+    explicit RssSampler(double period_ms = 20.0);
+    ~RssSampler();
+
+    RssSampler(const RssSampler &) = delete;
+    RssSampler & operator=(const RssSampler &) = delete;
+
+    // Peak since the construction, including the current value
+    double peak_mb();
+};
+
+// Admission control of tasks with a total memory budget.
+// A task reserves its estimated footprint before starting and waits
+// until it fits in the budget; a task is always admitted when nothing
+// else is running, so that a single oversized task cannot deadlock.
+class MemoryBudget {
+    double budget;
+    double reserved_ = 0.0;
+    std::mutex mtx;
+    std::condition_variable cv;
+
+public:
+    // budget in MB, zero or negative for no limit
+    explicit MemoryBudget(double budget_mb) : budget(budget_mb) {}
+
+    // Block until the task fits in the budget, then reserve its memory
+    void acquire(double mb);
+
+    // Give back the memory of a finished task
+    void release(double mb);
+
+    // Memory reserved by the tasks in flight
+    double reserved();
+};
+
+/************************************************************/
+
+namespace detail {
+    // Value in kB of a field of /proc/self/status, e.g. "VmRSS:"
+    inline double status_field_kb(const std::string & field) {
+        std::ifstream status{"/proc/self/status"};
+        std::string key;
+        double value;
+        while (status >> key) {
+            if (key == field && status >> value)
+                return value;
+            status.ignore(4096, '\n');
+        }
+        return 0.0;
+    }
+}
+
+inline double rss_mb() {
+    return detail::status_field_kb("VmRSS:") / 1024.0;
+}
+
+inline double peak_rss_mb() {
+    return detail::status_field_kb("VmHWM:") / 1024.0;
+}
+
+inline bool reset_peak_rss() {
+    std::ofstream clear_refs{"/proc/self/clear_refs"};
+    return bool(clear_refs << "5" << std::flush);
+}
+
+
+inline
+RssSampler::RssSampler(double period_ms) : peak(rss_mb()) {
+    sampler = std::thread([this, period_ms]{
+            auto period = std::chrono::duration<double, std::milli>(period_ms);
+            std::unique_lock<std::mutex> lock(mtx);
+            while (!cv.wait_for(lock, period, [this]{ return stop; })) {
+                lock.unlock();
+                auto current = rss_mb();
+                lock.lock();
+                peak = std::max(peak, current);
+            }
+        });
+}
+
+inline
+RssSampler::~RssSampler() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop = true;
+    }
+    cv.notify_all();
+    sampler.join();
+}
+
+inline double
+RssSampler::peak_mb() {
+    auto current = rss_mb();
+    std::lock_guard<std::mutex> lock(mtx);
+    peak = std::max(peak, current);
+    return peak;
+}
+
+
+inline void
+MemoryBudget::acquire(double mb) {
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [&]{
+            return budget <= 0.0 || reserved_ == 0.0 || reserved_ + mb <= budget;
+        });
+    reserved_ += mb;
+}
+
+inline void
+MemoryBudget::release(double mb) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        reserved_ -= mb;
+        if (reserved_ < 1e-9)
+            reserved_ = 0.0;
+    }
+    cv.notify_all();
+}
+
+inline double
+MemoryBudget::reserved() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return reserved_;
+}
+
+}
+
+#endif
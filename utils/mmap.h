@@ -0,0 +1,79 @@
+#ifndef __CLOCK_UTILS_MMAP_H
+#define __CLOCK_UTILS_MMAP_H
+
+#include <string>
+#include <streambuf>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/************************************************************/
+namespace utils {
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+    const char * data_ = nullptr;
+    std::size_t size_ = 0;
+
+public:
+    explicit MappedFile(const std::string & filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile && other) noexcept :
+        data_(std::exchange(other.data_, nullptr)),
+        size_(std::exchange(other.size_, 0)) {}
+
+    const char * data() const { return data_; }
+    std::size_t  size() const { return size_; }
+};
+
+// Stream buffer reading directly from a memory region (e.g. a MappedFile),
+// so that std::istream based readers do not copy the data in a buffer
+class memory_buf : public std::streambuf {
+public:
+    memory_buf(const char * begin, std::size_t size) {
+        auto ptr = const_cast<char *>(begin);
+        setg(ptr, ptr, ptr + size);
+    }
+};
+
+/************************************************************/
+
+inline MappedFile::MappedFile(const std::string & filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open file '" + filename + "'");
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat file '" + filename + "'");
+    }
+    size_ = info.st_size;
+
+    if (size_ > 0) {
+        void * addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map file '" + filename + "'");
+        }
+        data_ = static_cast<const char *>(addr);
+    }
+    // the mapping stays valid after closing the descriptor
+    ::close(fd);
+}
+
+inline MappedFile::~MappedFile() {
+    if (data_ != nullptr)
+        ::munmap(const_cast<char *>(data_), size_);
+}
+
+}
+
+#endif
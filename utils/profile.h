@@ -0,0 +1,171 @@
+#ifndef __CLOCK_UTILS_PROFILE_H
+#define __CLOCK_UTILS_PROFILE_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+#include "time.h"
+#include "timer.h"
+#include "allocations.h"
+
+/************************************************************/
+namespace utils {
+
+// Time spent in a scope and heap allocations made in it, summed over
+// its calls (the allocations only if counted, see allocations.h)
+struct ProfileEntry {
+    double seconds = 0.0;
+    unsigned long calls = 0;
+    unsigned long allocations = 0;
+    unsigned long bytes = 0;
+    std::size_t largest = 0;    // largest single allocation
+};
+
+// Entries by path of nested scope names, e.g. "point/ground_state/dmrg".
+// Scope names should not contain characters sorting before '/', so that
+// the map order is the order of a depth-first visit of the scopes
+using Profile = std::map<std::string, ProfileEntry>;
+
+// Timer of a scope, nested in the scopes open on the same thread.
+// The time and the allocations are accumulated in a thread-local profile,
+// collected with take_profile(), so that no synchronization is needed
+class ScopedTimer {
+    Timer timer;
+    std::size_t parent_size;
+    AllocationStats at_start;
+
+public:
+    explicit ScopedTimer(const char * name);
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer & operator=(const ScopedTimer &) = delete;
+};
+
+// Return and clear the profile accumulated by the current thread
+inline Profile take_profile();
+
+// Add the entries of a profile to another
+inline void merge_profile(Profile & total, const Profile & profile);
+
+// Print a profile as an indented tree, with the share of each scope
+// in its parent and, if counted, the allocations
+inline void print_profile(std::ostream & output, const Profile & profile);
+
+// Thread-safe sum of the profiles of many points
+class ProfileSum {
+    Profile total_{};
+    std::mutex mtx;
+
+public:
+    void add(const Profile & profile) {
+        std::lock_guard<std::mutex> lock(mtx);
+        merge_profile(total_, profile);
+    }
+
+    Profile total() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return total_;
+    }
+};
+
+/************************************************************/
+
+namespace detail {
+    // Profile and path of the open scopes of the current thread
+    inline Profile & thread_profile() {
+        static thread_local Profile profile{};
+        return profile;
+    }
+
+    inline std::string & thread_scope() {
+        static thread_local std::string path{};
+        return path;
+    }
+}
+
+inline
+ScopedTimer::ScopedTimer(const char * name) {
+    auto & path = detail::thread_scope();
+    parent_size = path.size();
+    if (!path.empty())
+        path += '/';
+    path += name;
+
+    // the largest allocation is tracked from zero in each scope,
+    // and given back to the enclosing one at the end
+    auto & allocs = thread_allocations();
+    at_start = allocs;
+    allocs.largest = 0;
+    timer.start();
+}
+
+inline
+ScopedTimer::~ScopedTimer() {
+    timer.stop();
+    auto allocs = thread_allocations();
+    thread_allocations().largest = std::max(at_start.largest, allocs.largest);
+
+    auto & path = detail::thread_scope();
+    auto & entry = detail::thread_profile()[path];
+    entry.seconds += timer.duration<time::ns>() * 1e-9;
+    entry.calls++;
+    entry.allocations += allocs.count - at_start.count;
+    entry.bytes += allocs.bytes - at_start.bytes;
+    entry.largest = std::max(entry.largest, allocs.largest);
+    path.resize(parent_size);
+}
+
+inline Profile take_profile() {
+    Profile profile{};
+    std::swap(profile, detail::thread_profile());
+    return profile;
+}
+
+inline void merge_profile(Profile & total, const Profile & profile) {
+    for (const auto & [path, entry] : profile) {
+        auto & sum = total[path];
+        sum.seconds += entry.seconds;
+        sum.calls += entry.calls;
+        sum.allocations += entry.allocations;
+        sum.bytes += entry.bytes;
+        sum.largest = std::max(sum.largest, entry.largest);
+    }
+}
+
+inline void print_profile(std::ostream & output, const Profile & profile) {
+    bool with_allocations = allocations_counted();
+    for (const auto & [path, entry] : profile) {
+        auto depth = std::count(path.begin(), path.end(), '/');
+        auto name_pos = path.rfind('/');
+        auto name = name_pos == std::string::npos ? path : path.substr(name_pos + 1);
+
+        // share of the parent scope, if it was timed
+        double share = 100.0;
+        if (name_pos != std::string::npos) {
+            auto parent = profile.find(path.substr(0, name_pos));
+            if (parent != profile.end() && parent->second.seconds > 0.0)
+                share = 100.0 * entry.seconds / parent->second.seconds;
+        }
+
+        output << "   " << std::string(2 * depth, ' ')
+               << std::left << std::setw(std::max(0, 24 - 2 * int(depth))) << name << std::right
+               << std::fixed << std::setprecision(3)
+               << std::setw(12) << entry.seconds << " s"
+               << std::setw(8) << std::setprecision(1) << share << " %"
+               << std::setw(10) << entry.calls << " calls";
+        if (with_allocations)
+            output << std::setw(12) << entry.allocations << " allocs"
+                   << std::setw(10) << std::setprecision(1) << entry.bytes / 1048576.0 << " MB"
+                   << std::setw(10) << std::setprecision(3) << entry.largest / 1048576.0 << " MB max";
+        output << "\n" << std::defaultfloat;
+    }
+}
+
+}
+
+#endif
@@ -116,7 +116,7 @@ public:
         }
     };
 
-    linspace(T begin, T end, std::size_t npoints) : npoints_(npoints) {
+    linspace(T begin, T end, std::size_t npoints) : start_(begin), stop_(end), npoints_(npoints) {
         T step = (end - begin) / T(npoints-1);
         begin_ = iterator(begin, step);
         end_ = iterator(end, step);
@@ -126,10 +126,17 @@ public:
     iterator end() { return end_; }
     std::size_t size() const { return npoints_; }
 
+    // n-th point, computed directly to avoid accumulating rounding errors
+    T at(std::size_t n) const {
+        if (n + 1 == npoints_)
+            return stop_;
+        return start_ + (stop_ - start_) * T(n) / T(npoints_ - 1);
+    }
+
     std::vector<T> to_vector() {
         std::vector<T> vec;
         vec.reserve(npoints_);
-        for (auto x : *this) vec.push_back(x);
+        for (std::size_t n = 0; n < npoints_; n++) vec.push_back(at(n));
         return vec;
     }
 
@@ -138,12 +145,12 @@ public:
         if (N != size())
             throw std::invalid_argument("Array of the wrong size");
         std::array<T, N> arr{T(0)};
-        size_t n = 0;
-        for (auto x : *this) { arr[n] = x; n++; }
+        for (std::size_t n = 0; n < N; n++) arr[n] = at(n);
         return arr;
     }
 
 private:
+    T start_, stop_;
     iterator begin_, end_;
     std::size_t npoints_;
 
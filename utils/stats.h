@@ -0,0 +1,67 @@
+#ifndef __CLOCK_UTILS_STATS_H
+#define __CLOCK_UTILS_STATS_H
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+/************************************************************/
+namespace utils {
+
+// Streaming mean and variance of a sequence of values (Welford), in
+// constant memory. Accumulators filled separately, e.g. by different
+// threads, are combined with merge (Chan, Golub, LeVeque)
+class RunningStats {
+    std::size_t n = 0;
+    double mean_ = 0.0;
+    double m2 = 0.0;        // sum of the squared deviations from the mean
+
+public:
+    void add(double x);
+    void merge(const RunningStats & other);
+
+    std::size_t count() const { return n; }
+
+    // NaN without values
+    double mean() const;
+    // Sample variance, NaN with less than two values
+    double variance() const;
+    double stddev() const { return std::sqrt(variance()); }
+    // Standard error of the mean, for independent values
+    double error() const { return std::sqrt(variance() / double(n)); }
+};
+
+/************************************************************/
+
+inline void RunningStats::add(double x) {
+    n++;
+    double delta = x - mean_;
+    mean_ += delta / double(n);
+    m2 += delta * (x - mean_);
+}
+
+inline void RunningStats::merge(const RunningStats & other) {
+    if (other.n == 0)
+        return;
+    if (n == 0) {
+        *this = other;
+        return;
+    }
+    double total = double(n + other.n);
+    double delta = other.mean_ - mean_;
+    mean_ += delta * double(other.n) / total;
+    m2 += other.m2 + delta * delta * double(n) * double(other.n) / total;
+    n += other.n;
+}
+
+inline double RunningStats::mean() const {
+    return n > 0 ? mean_ : std::numeric_limits<double>::quiet_NaN();
+}
+
+inline double RunningStats::variance() const {
+    return n > 1 ? m2 / double(n - 1) : std::numeric_limits<double>::quiet_NaN();
+}
+
+}
+
+#endif
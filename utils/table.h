@@ -9,8 +9,11 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <type_traits>
 
 #include "ranges.h"
+#include "format.h"
+#include "binary.h"
 
 using std::string;
 using std::string_view;
@@ -19,10 +22,16 @@ using std::cout;
 
 namespace utils {
 
+// Table of named columns.
+// Columns are stored in order and can be accessed either by id or by an
+// integer handle, resolved once with handle(id), for direct indexed access.
+// With a resizable container (e.g. std::vector) the table can be created
+// at runtime from a schema, i.e. the list of ids, and the number of rows.
 template<typename T>
 class Table {
     std::vector<string> column_ids{};
-    std::unordered_map<string, T> columns{};
+    std::vector<T> columns{};
+    std::unordered_map<string, std::size_t> handles{};
 
     unsigned precision_ = 8;
     unsigned column_width_ = 12;
@@ -30,46 +39,61 @@ class Table {
 public:
     using column_type = T;
     using item_type = typename T::value_type;
+    using handle_type = std::size_t;
 
     // Constructors
     Table();
     Table(string_view id, const T & column);
     template<typename ... Args>
     Table(string_view first_id, const T & first_column, const Args & ... other_cols);
+    // From a schema, only for resizable containers
+    Table(const std::vector<string> & schema, std::size_t nrows, item_type value = item_type{});
 
     // Add columns
-    Table add_columns(string_view id, const T & column);
+    Table & add_columns(string_view id, const T & column);
     template<typename ... Args>
-    Table add_columns(string_view first_id, const T & first_column, const Args & ... other_cols);
+    Table & add_columns(string_view first_id, const T & first_column, const Args & ... other_cols);
+
+    // Column handles
+    handle_type handle(const string & id) const;
+    bool contains(const string & id) const { return handles.count(id) > 0; }
 
     // Column access
-    T & operator[](const string & id) { return columns[id]; };
-    T & at(const string & id) { return columns.at(id); };
-    T & at(const string & id) const { return columns.at(id); };
+    T & operator[](const string & id) { return columns[handle(id)]; };
+    T & at(const string & id) { return columns.at(handle(id)); };
+    const T & at(const string & id) const { return columns.at(handle(id)); };
+    T & operator[](handle_type h) { return columns[h]; };
+    const T & operator[](handle_type h) const { return columns[h]; };
+
+    // Cell access through a handle
+    item_type & operator()(handle_type h, std::size_t row) { return columns[h][row]; }
+    const item_type & operator()(handle_type h, std::size_t row) const { return columns[h][row]; }
 
-    // Row access (very rough and inefficient)
+    // Row access (allocates a vector, prefer the cells access)
     auto row(std::size_t n) const {
         std::vector<item_type> row_{};
-        for (auto id : column_ids)
-            row_.push_back(columns.at(id).at(n));
+        row_.reserve(columns.size());
+        for (const auto & col : columns)
+            row_.push_back(col.at(n));
         return row_;
     }
 
     // Access useful info
     unsigned ncols()     const { return columns.size(); }
-    unsigned nrows()     const { return columns.begin()->second.size(); }
+    unsigned nrows()     const { return columns.empty() ? 0 : columns.front().size(); }
     unsigned size()      const { return ncols() * nrows(); }
     unsigned width()     const { return column_width_; }
     auto precision() const { return precision_; }
     const std::vector<string> & ids() const { return column_ids; }
 
     // Setters
-    Table set_width(unsigned int n) { column_width_ = n; return *this; }
-    Table set_precision(unsigned int n) { precision_ = n; return *this; }
+    Table & set_width(unsigned int n) { column_width_ = n; return *this; }
+    Table & set_precision(unsigned int n) { precision_ = n; return *this; }
 
     // Output (plus an overloaded operator<<)
     void print() const;
     void to_csv(string_view filename) const;
+    void to_binary(string_view filename) const;   // exact, see binary.h
 
     // helper functions for outputting
     void hrule(std::ostream & output) const;
@@ -78,20 +102,23 @@ public:
 
 
 template<typename T>
-Table<T>
+Table<T> &
 Table<T>::add_columns(string_view id, const T & column){
     if (!columns.empty())
         if (column.size() != nrows())
             throw std::invalid_argument("Wrong size container");
+    if (contains(string(id)))
+        throw std::invalid_argument("Column '" + string(id) + "' already present");
+    handles.emplace(string(id), columns.size());
     column_ids.emplace_back(string(id));
-    columns.insert(std::make_pair(id, column));
+    columns.push_back(column);
     return *this;
 };
 
 
 template<typename T>
 template<typename ... Args>
-Table<T>
+Table<T> &
 Table<T>::add_columns(
     string_view first_id,
     const T & first_column,
@@ -106,7 +133,25 @@ Table<T>::add_columns(
 
 
 template<typename T>
-Table<T>::Table() : column_ids(), columns() {}
+Table<T>::Table() : column_ids(), columns(), handles() {}
+
+
+template<typename T>
+Table<T>::Table(const std::vector<string> & schema, std::size_t nrows, item_type value) {
+    columns.reserve(schema.size());
+    for (const auto & id : schema)
+        add_columns(id, T(nrows, value));
+}
+
+
+template<typename T>
+typename Table<T>::handle_type
+Table<T>::handle(const string & id) const {
+    auto found = handles.find(id);
+    if (found == handles.end())
+        throw std::out_of_range("No column '" + id + "' in the table");
+    return found->second;
+}
 
 
 template<typename T>
@@ -151,8 +196,8 @@ operator<<(std::ostream & output, const Table<T> & table) {
 
     // Print the elements
     for (auto n : range(0u, table.nrows())) {
-        for (auto item : table.row(n))
-            output << std::setw(table.width()) << item;
+        for (auto h : range(0u, table.ncols()))
+            output << std::setw(table.width()) << table(h, n);
         output << "\n";
     }
     output << std::endl;
@@ -183,15 +228,43 @@ Table<T>::to_csv(string_view filename) const {
         file << *id << ",";
     file << column_ids.back() << "\n";
 
-    // Print columns
+    // Print columns, each line is formatted in a buffer and written at once
+    std::vector<const T *> cols{};
+    for (const auto & col : columns)
+        cols.push_back(&col);
+
+    string line{};
     for (auto n : range(0u, this->nrows())) {
-        auto row = this->row(n);
-        for (auto item = row.begin(); item != row.end()-1; item++)
-            file << *item << ",";
-        file << row.back() << "\n";
+        line.clear();
+        for (auto col = cols.begin(); col != cols.end(); col++) {
+            if (col != cols.begin())
+                line += ',';
+            if constexpr (std::is_floating_point_v<item_type>) {
+                append_number(line, (**col)[n], this->precision());
+            } else {
+                line += std::to_string((**col)[n]);
+            }
+        }
+        line += '\n';
+        file.write(line.data(), line.size());
     }
 }
 
+
+
+template<typename T>
+void
+Table<T>::to_binary(string_view filename) const {
+    static_assert(std::is_same_v<item_type, double>, "Binary tables store only doubles");
+    std::cout << "   Writing contents onto file '" << filename << "'\n";
+
+    // columns have to be contiguous, like std::array and std::vector
+    std::vector<const double *> cols{};
+    for (const auto & col : columns)
+        cols.push_back(col.data());
+    write_binary(filename, column_ids, cols, nrows());
+}
+
 }
 
 #endif
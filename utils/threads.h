@@ -0,0 +1,243 @@
+#ifndef __CLOCK_UTILS_THREADS_H
+#define __CLOCK_UTILS_THREADS_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <thread>
+
+#include <sched.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// BLAS thread control, resolved at link time only if the library provides it.
+// MKL sets the threads of the calling thread only, OpenBLAS for the whole process
+extern "C" {
+    void openblas_set_num_threads(int) __attribute__((weak));
+    int  openblas_get_num_threads() __attribute__((weak));
+    int  mkl_set_num_threads_local(int) __attribute__((weak));
+    void mkl_set_dynamic(int) __attribute__((weak));
+}
+
+/************************************************************/
+namespace utils {
+
+// Split of the cores between concurrent tasks (workers) and the BLAS
+// threads used by each task
+struct ThreadPlan {
+    unsigned workers;
+    unsigned blas_threads;
+    bool     pin;
+    unsigned slice = 0;     // cores pinned per worker, 0 for blas_threads
+};
+
+// Cores the process is allowed to run on
+inline std::vector<int> allowed_cores();
+
+// Allowed cores, grouped by NUMA node
+inline std::vector<int> cores_by_node();
+
+// Default number of BLAS threads for a DMRG of the given size:
+// large bond dimensions profit from a multithreaded BLAS, while
+// small contractions are faster single threaded
+inline unsigned default_blas_threads(unsigned length, int maxdim);
+
+// Plan for the available cores, workers = 0 means as many as possible.
+// To be called before the parallel region of the workers: with more than
+// one BLAS thread it enables the nested parallel regions of the BLAS.
+// OpenBLAS has a single thread count for the whole process, which the
+// workers would overwrite concurrently, so with OpenBLAS and more than
+// one worker the plan has a single BLAS thread
+inline ThreadPlan make_thread_plan(unsigned workers, unsigned blas_threads, bool pin);
+
+// Plan of a task run by one of the given workers, which share the allowed
+// cores in fixed slices of the same size: the task keeps its BLAS threads
+// up to the size of the slice, so that the workers running tasks with
+// different plans, e.g. in a campaign, never pin to overlapping cores
+inline ThreadPlan in_worker_slice(const ThreadPlan & plan, unsigned workers);
+
+// Let the BLAS threads of each worker run as a nested parallel region:
+// inside an OpenMP worker MKL is sequential unless the nested levels are
+// active and its dynamic adjustment of the threads is off
+inline void enable_nested_blas(unsigned blas_threads);
+
+// Index of the calling thread in the current parallel region
+inline unsigned thread_id();
+
+// Set the BLAS threads of the calling thread (of the process with
+// OpenBLAS), returning the previous value (0 if unknown)
+inline int set_blas_threads(unsigned n);
+
+// Pin the calling thread to the cores of the worker slot, filling
+// the NUMA nodes one after the other
+inline void pin_worker(unsigned worker, unsigned cores_per_worker);
+
+// Plan applied to the calling worker for the lifetime of the object: the
+// affinity and the BLAS threads of the thread are restored at the end of
+// the scope, so that the master thread, which is a worker too, and later
+// plans see all the allowed cores again
+class ScopedThreadPlan {
+    bool pinned = false;
+    cpu_set_t saved_mask;
+    int saved_blas;
+
+public:
+    ScopedThreadPlan(const ThreadPlan & plan, unsigned worker);
+    ~ScopedThreadPlan();
+
+    ScopedThreadPlan(const ScopedThreadPlan &) = delete;
+    ScopedThreadPlan & operator=(const ScopedThreadPlan &) = delete;
+};
+
+/************************************************************/
+
+inline std::vector<int>
+allowed_cores() {
+    std::vector<int> cores{};
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; c++)
+            if (CPU_ISSET(c, &mask))
+                cores.push_back(c);
+    }
+    if (cores.empty())
+        for (int c = 0; c < int(std::max(1u, std::thread::hardware_concurrency())); c++)
+            cores.push_back(c);
+    return cores;
+}
+
+inline std::vector<int>
+cores_by_node() {
+    auto allowed = allowed_cores();
+    std::vector<int> ordered{};
+
+    // cpulist of each node, e.g. "0-7,16-23"
+    for (int node = 0; ; node++) {
+        std::ifstream file{"/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"};
+        if (!file)
+            break;
+        std::string list, item;
+        std::getline(file, list);
+        std::istringstream items{list};
+        while (std::getline(items, item, ',')) {
+            auto dash = item.find('-');
+            int first = std::stoi(item.substr(0, dash));
+            int last  = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+            for (int c = first; c <= last; c++)
+                if (std::find(allowed.begin(), allowed.end(), c) != allowed.end())
+                    ordered.push_back(c);
+        }
+    }
+
+    // no NUMA information, or some cores missing from it
+    if (ordered.size() != allowed.size())
+        return allowed;
+    return ordered;
+}
+
+inline unsigned
+default_blas_threads(unsigned length, int maxdim) {
+    if (length < 20 || maxdim < 200)
+        return 1;
+    if (maxdim < 400)
+        return 2;
+    if (maxdim < 1000)
+        return 4;
+    return 8;
+}
+
+inline ThreadPlan
+make_thread_plan(unsigned workers, unsigned blas_threads, bool pin) {
+    unsigned cores = allowed_cores().size();
+    blas_threads = std::clamp(blas_threads, 1u, cores);
+    if (!mkl_set_num_threads_local && openblas_set_num_threads && workers != 1)
+        blas_threads = 1;
+    if (workers == 0)
+        workers = std::max(1u, cores / blas_threads);
+    enable_nested_blas(blas_threads);
+    return ThreadPlan{workers, blas_threads, pin};
+}
+
+inline ThreadPlan
+in_worker_slice(const ThreadPlan & plan, unsigned workers) {
+    workers = std::max(workers, 1u);
+    unsigned slice = std::max(1u, unsigned(allowed_cores().size()) / workers);
+    unsigned blas_threads = std::min(plan.blas_threads, slice);
+    if (!mkl_set_num_threads_local && openblas_set_num_threads && workers != 1)
+        blas_threads = 1;
+    return ThreadPlan{workers, blas_threads, plan.pin, slice};
+}
+
+inline void
+enable_nested_blas(unsigned blas_threads) {
+    if (blas_threads <= 1)
+        return;
+#ifdef _OPENMP
+    if (omp_get_max_active_levels() < 2)
+        omp_set_max_active_levels(2);
+#endif
+    if (mkl_set_dynamic)
+        mkl_set_dynamic(0);
+}
+
+inline unsigned
+thread_id() {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+inline int
+set_blas_threads(unsigned n) {
+    if (mkl_set_num_threads_local)
+        return mkl_set_num_threads_local(n);
+    int previous = openblas_get_num_threads ? openblas_get_num_threads() : 0;
+    if (openblas_set_num_threads)
+        openblas_set_num_threads(n);
+    return previous;
+}
+
+inline void
+pin_worker(unsigned worker, unsigned cores_per_worker) {
+    auto cores = cores_by_node();
+    if (cores.empty())
+        return;
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (unsigned n = 0; n < cores_per_worker; n++)
+        CPU_SET(cores.at((worker * cores_per_worker + n) % cores.size()), &mask);
+    // pid 0 is the calling thread
+    sched_setaffinity(0, sizeof(mask), &mask);
+}
+
+inline
+ScopedThreadPlan::ScopedThreadPlan(const ThreadPlan & plan, unsigned worker) {
+    CPU_ZERO(&saved_mask);
+    if (plan.pin && sched_getaffinity(0, sizeof(saved_mask), &saved_mask) == 0) {
+        pin_worker(worker, plan.slice > 0 ? plan.slice : plan.blas_threads);
+        pinned = true;
+    }
+    saved_blas = set_blas_threads(plan.blas_threads);
+}
+
+inline
+ScopedThreadPlan::~ScopedThreadPlan() {
+    if (pinned)
+        sched_setaffinity(0, sizeof(saved_mask), &saved_mask);
+    // 0 is the global default of MKL, unknown with OpenBLAS
+    if (mkl_set_num_threads_local)
+        mkl_set_num_threads_local(saved_blas);
+    else if (saved_blas > 0)
+        set_blas_threads(saved_blas);
+}
+
+}
+
+#endif
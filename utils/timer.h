@@ -51,7 +51,7 @@ public:
 };
 
 
-std::ostream &
+inline std::ostream &
 operator<<(std::ostream & output, const Timer & timer) {
     auto time_ms = timer.duration<time::s>();
     if (time_ms == 0) {
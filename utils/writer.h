@@ -0,0 +1,157 @@
+#ifndef __CLOCK_UTILS_WRITER_H
+#define __CLOCK_UTILS_WRITER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "format.h"
+
+/************************************************************/
+namespace utils {
+
+// Streaming writer for the rows of a table.
+// Rows are pushed as soon as they are computed and appended, in
+// completion order and prefixed by their index, to '<filename>.part'
+// by a background thread. finish() waits for the pending rows and
+// writes '<filename>' as a csv sorted by row index.
+class RowWriter {
+    using Row = std::pair<std::size_t, std::vector<double>>;
+
+    std::string filename;
+    std::vector<std::string> ids;
+    unsigned precision;
+
+    std::vector<Row> pending{};
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool stopping = false;
+    bool finished = false;
+    std::thread worker;
+
+public:
+    RowWriter(std::string_view filename_, const std::vector<std::string> & ids_, unsigned precision_ = 8);
+    ~RowWriter() { finish(); }
+
+    RowWriter(const RowWriter &) = delete;
+    RowWriter & operator=(const RowWriter &) = delete;
+
+    // Queue a row, the values in the order of the ids
+    void push(std::size_t row, std::vector<double> values);
+
+    // Write the remaining rows and the final sorted file
+    void finish();
+
+private:
+    std::string part_filename() const { return filename + ".part"; }
+    void run();
+    void write_sorted();
+};
+
+/************************************************************/
+
+inline
+RowWriter::RowWriter(
+    std::string_view filename_,
+    const std::vector<std::string> & ids_,
+    unsigned precision_
+) : filename(filename_), ids(ids_), precision(precision_) {
+    std::ofstream file{part_filename(), std::ios::trunc};
+    file << "row";
+    for (const auto & id : ids)
+        file << "," << id;
+    file << "\n";
+    worker = std::thread(&RowWriter::run, this);
+}
+
+inline void
+RowWriter::push(std::size_t row, std::vector<double> values) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending.emplace_back(row, std::move(values));
+    }
+    cv.notify_one();
+}
+
+inline void
+RowWriter::run() {
+    std::ofstream file{part_filename(), std::ios::app};
+    std::vector<Row> batch{};
+    std::string text{};
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this]{ return stopping || !pending.empty(); });
+            if (pending.empty() && stopping)
+                break;
+            batch.swap(pending);
+        }
+
+        // Format the whole batch and write it at once
+        text.clear();
+        for (const auto & [row, values] : batch) {
+            text += std::to_string(row);
+            for (auto value : values) {
+                text += ',';
+                append_number(text, value, precision);
+            }
+            text += '\n';
+        }
+        file.write(text.data(), text.size());
+        file.flush();
+        batch.clear();
+    }
+}
+
+inline void
+RowWriter::finish() {
+    if (finished)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cv.notify_one();
+    worker.join();
+    write_sorted();
+    finished = true;
+}
+
+inline void
+RowWriter::write_sorted() {
+    // Read back the streamed rows, keeping the cells as text
+    std::ifstream part{part_filename()};
+    std::string line;
+    std::getline(part, line);
+    std::vector<std::pair<std::size_t, std::string>> rows{};
+    while (std::getline(part, line)) {
+        auto comma = line.find(',');
+        if (comma == std::string::npos)
+            continue;
+        rows.emplace_back(std::stoul(line.substr(0, comma)), line.substr(comma + 1));
+    }
+    std::stable_sort(rows.begin(), rows.end(),
+            [](const auto & a, const auto & b){ return a.first < b.first; });
+
+    std::cout << "   Writing contents onto file '" << filename << "'\n";
+    std::ofstream file{filename, std::ios::trunc};
+    for (auto id = ids.begin(); id != ids.end(); id++)
+        file << (id == ids.begin() ? "" : ",") << *id;
+    file << "\n";
+    for (const auto & row : rows)
+        file << row.second << "\n";
+    file.close();
+    std::remove(part_filename().c_str());
+}
+
+}
+
+#endif